@@ -0,0 +1,78 @@
+#ifndef CGROUP_THROTTLE_HPP
+#define CGROUP_THROTTLE_HPP
+
+/**
+ * @file cgroup_throttle.hpp
+ * @brief cgroup v2 CPU limits used as a second thermal actuator after the fan
+ */
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+class CgroupThrottle {
+public:
+    enum class Mode {
+        MAX,     // cpu.max quota as a percentage of all online CPUs
+        WEIGHT   // cpu.weight as a percentage of the original weight
+    };
+
+    CgroupThrottle() = default;
+    ~CgroupThrottle();
+
+    CgroupThrottle(const CgroupThrottle&) = delete;
+    CgroupThrottle& operator=(const CgroupThrottle&) = delete;
+
+    // Open control files and remember their original values; steps are percentages, strongest last
+    bool open(const std::vector<std::string>& cgroup_paths, Mode mode,
+              const std::vector<double>& steps);
+
+    // 0 = unthrottled, 1..stepCount() = index into steps
+    int step() const { return step_; }
+    int stepCount() const { return static_cast<int>(steps_.size()); }
+    bool setStep(int step, double now_seconds);
+
+    // Put original limits back; safe to call more than once
+    void restore(double now_seconds);
+
+    double interventionSeconds(double now_seconds) const;
+    // CPU time withheld by a limit is not exposed by cgroupfs, so what the limit
+    // did is reported as two measured figures instead:
+    // usage_usec accumulated while a step was engaged, in CPU-seconds
+    double usedCpuSecondsWhileLimited() const;
+    // throttled_usec over the same windows: run queue time spent out of quota,
+    // summed over CPUs; always 0 in weight mode, which never throttles
+    double outOfQuotaSeconds() const;
+    std::string report(double now_seconds) const;
+
+private:
+    struct Group {
+        std::string path;
+        int control_fd = -1;
+        int stat_fd = -1;
+        std::string original;
+        int64_t original_quota = -1;   // -1 = "max"
+        int64_t period = 100000;
+        int64_t original_weight = 100;
+        uint64_t usage_usec_start = 0;       // at the start of the current engagement
+        uint64_t throttled_usec_start = 0;
+        uint64_t usage_usec_engaged = 0;     // completed engagements
+        uint64_t throttled_usec_engaged = 0;
+    };
+
+    Mode mode_ = Mode::MAX;
+    std::vector<double> steps_;
+    std::vector<Group> groups_;
+    int step_ = 0;
+    long cpus_ = 1;
+    double intervention_seconds_ = 0.0;
+    double engaged_since_ = 0.0;
+
+    static bool readFd(int fd, std::string& value);
+    static bool writeFd(int fd, const std::string& value);
+    static uint64_t readStatUsec(int stat_fd, const char* field);
+    std::string limitFor(const Group& group, double percent) const;
+    void closeAll();
+};
+
+#endif // CGROUP_THROTTLE_HPP
@@ -8,8 +8,20 @@
 
 #include <string>
 #include <map>
+#include <set>
+#include <vector>
 #include <cstdint>
 
+// Model coefficients for one virtual sensor (see virtual_sensor.hpp)
+struct VirtualSensorConfig {
+    std::string name;
+    std::vector<double> a;
+    std::vector<double> b;
+    std::vector<double> c;
+    std::vector<double> d;
+    bool fuse = false;
+};
+
 // Configuration structure with default values
 struct FanControllerConfig {
     std::string fan_path = "/sys/class/thermal/cooling_device0/cur_state";
@@ -27,6 +39,42 @@ struct FanControllerConfig {
 
     int interval_seconds = 15;
     bool debug = false;
+
+    // Optional policy expression replacing the threshold ladder (empty = ladder)
+    std::string policy_expr;
+    int policy_window = 8;
+
+    std::vector<VirtualSensorConfig> virtual_sensors;
+
+    // cgroup v2 throttling of batch work once the fan is at FULL (no paths = disabled)
+    std::vector<std::string> cgroup_throttle_paths;
+    std::string cgroup_throttle_mode = "max";
+    std::vector<double> cgroup_throttle_steps = {75.0, 50.0, 25.0};
+    double cgroup_throttle_temp = 75.0;
+    double cgroup_throttle_hysteresis = 2.0;
+
+    // Program kernel trip points and only supervise (falls back to polling if unsupported)
+    bool kernel_offload = false;
+    int kernel_offload_supervise_seconds = 300;
+
+    // Online bandit tuning of threshold/hysteresis offsets
+    bool tuner = false;
+    std::string tuner_state_path = "/var/lib/pi5-fan-controller/tuner.state";
+    int tuner_epoch_cycles = 240;
+    std::vector<double> tuner_offsets = {-2.0, -1.0, 0.0, 1.0, 2.0};
+    std::vector<double> tuner_hysteresis_offsets = {0.0, 0.5, 1.0};
+    double tuner_throttle_temp = 80.0;
+    double tuner_safety_margin = 5.0;
+    std::vector<double> tuner_weights = {1.0, 0.05, 5.0};
+
+    // Read well-correlated sensors at a reduced rate and estimate in between
+    bool subsample = false;
+    int subsample_factor = 4;
+    double subsample_min_correlation = 0.98;
+    double subsample_max_residual = 0.5;
+
+    // File the configuration was read from (empty when taken from the environment)
+    std::string config_path;
 };
 
 class ConfigParser {
@@ -37,7 +85,16 @@ public:
 
 private:
     static std::string trim(const std::string& str);
+    static bool isConfigKey(const std::string& name);
+    static bool parseBool(const std::string& value);
+    static std::vector<std::string> splitList(const std::string& value);
+    static std::vector<double> parseDoubleList(const std::string& value);
     static std::map<std::string, std::string> parseKeyValueFile(const std::string& path);
+    // looked_up, if given, receives every key that was searched for
+    static void applyKeyValues(const std::map<std::string, std::string>& kv_map,
+                               FanControllerConfig& config,
+                               std::set<std::string>* looked_up = nullptr);
+    static void resolveSensorPaths(FanControllerConfig& config);
     static std::string findHwmonDeviceByName(const std::string& device_name);
 };
 
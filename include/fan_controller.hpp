@@ -7,9 +7,19 @@
  */
 
 #include "config_parser.hpp"
+#include "policy_expression.hpp"
+#include "temperature_window.hpp"
+#include "virtual_sensor.hpp"
+#include "system_load.hpp"
+#include "cgroup_throttle.hpp"
+#include "kernel_offload.hpp"
+#include "threshold_tuner.hpp"
+#include "sensor_subsampler.hpp"
 #include <string>
 #include <atomic>
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 // Fan speed levels
 enum class FanSpeed : int {
@@ -29,13 +39,59 @@ public:
     void run();
     void stop();
 
+    // One threshold-ladder decision (target plus hysteresis) from a given speed, for simulation
+    FanSpeed ladderDecision(double temperature, FanSpeed current_speed);
+
 private:
     FanControllerConfig config_;
     std::atomic<FanSpeed> current_fan_speed_;
     std::atomic<bool> running_;
 
+    // Latest per-sensor readings (NaN when a sensor failed this cycle)
+    double hwmon0_temp_;
+    double hwmon1_temp_;
+
+    // Offsets applied to the threshold ladder by the online tuner
+    double threshold_offset_;
+    double hysteresis_offset_;
+    TemperatureWindow temp_window_;
+
+    // Reduced-rate reads of sensors predictable from another channel
+    std::unique_ptr<SensorSubsampler> subsampler_;
+
+    // Model-based estimates for components without a sensor
+    std::vector<VirtualSensor> virtual_sensors_;
+    std::unique_ptr<SystemLoad> system_load_;
+
+    // Secondary actuator for batch cgroups, engaged only at FULL
+    std::unique_ptr<CgroupThrottle> cgroup_throttle_;
+
+    // Kernel trip programming; null when running the userspace loop
+    std::unique_ptr<KernelOffload> kernel_offload_;
+    KernelOffload::Stats offload_stats_;
+    int64_t config_mtime_;   // ns, -1 when unknown
+
+    std::unique_ptr<ThresholdTuner> tuner_;
+
+    // Compiled POLICY_EXPR and its variable slots, sized once in initialize()
+    PolicyExpression policy_;
+    std::vector<std::string> policy_var_names_;
+    std::vector<double> policy_vars_;
+
     double readTemperatureSensor(const std::string& temp_path) const;
-    double getAverageTemperature() const;
+    double getAverageTemperature();
+    bool initializeVirtualSensors();
+    void updateVirtualSensors(double soc_temp);
+    bool compilePolicy();
+    FanSpeed evaluatePolicy(double temperature);
+    bool initializeCgroupThrottle();
+    void updateCgroupThrottle(double temperature);
+    bool initializeTuner();
+    void updateTuner(double temperature);
+    void initializeKernelOffload();
+    bool programKernelTrips();
+    bool superviseKernelOffload();
+    bool reloadKernelOffloadConfig();
     FanSpeed determineTargetSpeed(double temperature) const;
     bool checkHysteresis(double temperature, FanSpeed target_speed) const;
     double getThresholdForSpeed(FanSpeed speed) const;
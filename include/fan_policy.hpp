@@ -0,0 +1,41 @@
+#ifndef FAN_POLICY_HPP
+#define FAN_POLICY_HPP
+
+/**
+ * @file fan_policy.hpp
+ * @brief Common interface for fan policies run by the simulator
+ */
+
+#include "config_parser.hpp"
+#include "fan_controller.hpp"
+#include <string>
+
+class FanPolicy {
+public:
+    virtual ~FanPolicy() = default;
+
+    virtual std::string name() const = 0;
+
+    // Seconds until the next decision (control interval or zone polling delay)
+    virtual double pollInterval(double temperature) const = 0;
+
+    virtual void reset() = 0;
+    virtual int decide(double temperature, int current_level) = 0;
+};
+
+// The controller's own threshold ladder with hysteresis
+class LadderPolicy : public FanPolicy {
+public:
+    explicit LadderPolicy(const FanControllerConfig& config);
+
+    std::string name() const override { return "ladder"; }
+    double pollInterval(double) const override { return interval_seconds_; }
+    void reset() override {}
+    int decide(double temperature, int current_level) override;
+
+private:
+    FanController controller_;
+    double interval_seconds_;
+};
+
+#endif // FAN_POLICY_HPP
@@ -0,0 +1,65 @@
+#ifndef JOURNAL_IMPORTER_HPP
+#define JOURNAL_IMPORTER_HPP
+
+/**
+ * @file journal_importer.hpp
+ * @brief Converts journald exports of controller logs into thermal traces
+ *
+ * Accepts `journalctl -o export` and `journalctl -o json` output. Lines of the
+ * form "T:61.5°C S:LOW -> MEDIUM" (transitions) and "T:61.5°C S:LOW" (debug
+ * samples) are turned into trace records keyed by _HOSTNAME. Regular files are
+ * mapped and scanned in place; pipes are parsed chunk by chunk.
+ */
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+class JournalImporter {
+public:
+    explicit JournalImporter(std::FILE* output);
+
+    bool importFile(const std::string& path);
+    bool finish();
+    void printSummary(std::ostream& out) const;
+
+private:
+    struct NodeTimeline {
+        int level = -1;
+        int64_t first_us = 0;
+        int64_t last_us = 0;
+        size_t samples = 0;
+        size_t transitions = 0;
+        size_t gaps = 0;
+        std::array<double, 5> level_seconds{};
+    };
+
+    static constexpr size_t OUTPUT_BUFFER_SIZE = 1 << 20;
+
+    std::FILE* output_;
+    std::string buffer_;
+    std::map<std::string, NodeTimeline, std::less<>> nodes_;
+    size_t bytes_ = 0;
+    size_t controller_lines_ = 0;
+    size_t skipped_ = 0;
+    double elapsed_seconds_ = 0.0;
+    bool write_failed_ = false;
+
+    // Return how many bytes of complete entries were consumed; at_end also
+    // accepts a final entry without its terminator
+    size_t parse(std::string_view data, bool at_end);
+    size_t parseExport(std::string_view data, bool at_end);
+    size_t parseJson(std::string_view data, bool at_end);
+    void handleEntry(std::string_view node, std::string_view timestamp, std::string_view message);
+    void flush();
+
+    static bool parseMessage(std::string_view message, double& temperature,
+                             int& from_level, int& to_level);
+    static int parseLevel(std::string_view name);
+};
+
+#endif // JOURNAL_IMPORTER_HPP
@@ -0,0 +1,98 @@
+#ifndef KERNEL_GOVERNORS_HPP
+#define KERNEL_GOVERNORS_HPP
+
+/**
+ * @file kernel_governors.hpp
+ * @brief Userspace emulations of the kernel thermal governors for baseline comparison
+ *
+ * The zone is modelled the way the Pi 5 device tree binds the fan: one active
+ * trip per level (LOW..FULL thresholds, configured hysteresis) whose thermal
+ * instance is limited to exactly that level, polled every polling delay.
+ * Trip crossings follow the kernel's threshold handling: a trip is crossed
+ * upwards at its temperature and downwards below temperature - hysteresis.
+ */
+
+#include "config_parser.hpp"
+#include "fan_policy.hpp"
+#include <vector>
+
+struct GovernorZone {
+    struct Trip {
+        double temperature;
+        double hysteresis;
+        int lower;
+        int upper;
+    };
+
+    std::vector<Trip> trips;
+    int max_state = 4;
+    double polling_delay = 1.0;   // seconds
+    double passive_delay = 1.0;   // seconds, used by power_allocator above switch-on
+
+    static GovernorZone fromConfig(const FanControllerConfig& config, double polling_delay);
+};
+
+// step_wise: one state up per poll while a trip is exceeded and rising, one down while dropping
+class StepWiseGovernor : public FanPolicy {
+public:
+    explicit StepWiseGovernor(const GovernorZone& zone);
+
+    std::string name() const override { return "step_wise"; }
+    double pollInterval(double) const override { return zone_.polling_delay; }
+    void reset() override;
+    int decide(double temperature, int current_level) override;
+
+private:
+    static constexpr int NO_TARGET = -1;
+
+    struct Instance {
+        double threshold;
+        int target = NO_TARGET;
+        bool initialized = false;
+    };
+
+    GovernorZone zone_;
+    std::vector<Instance> instances_;
+    double last_temperature_;
+};
+
+// bang_bang: each trip switches its instance fully on (1) or off (0)
+class BangBangGovernor : public FanPolicy {
+public:
+    explicit BangBangGovernor(const GovernorZone& zone);
+
+    std::string name() const override { return "bang_bang"; }
+    double pollInterval(double) const override { return zone_.polling_delay; }
+    void reset() override;
+    int decide(double temperature, int current_level) override;
+
+private:
+    GovernorZone zone_;
+    std::vector<int> targets_;
+};
+
+// power_allocator: PID on the control temperature allocating a power budget
+class PowerAllocatorGovernor : public FanPolicy {
+public:
+    // Powers in mW like the zone's sustainable_power, temperatures in °C
+    explicit PowerAllocatorGovernor(const GovernorZone& zone, double sustainable_power = 1000.0);
+
+    std::string name() const override { return "power_allocator"; }
+    double pollInterval(double temperature) const override;
+    void reset() override;
+    int decide(double temperature, int current_level) override;
+
+private:
+    GovernorZone zone_;
+    double switch_on_temp_;
+    double control_temp_;
+    double sustainable_power_;
+    double max_power_;
+    double k_po_;
+    double k_pu_;
+    double k_i_;
+    double integral_cutoff_;
+    double err_integral_;
+};
+
+#endif // KERNEL_GOVERNORS_HPP
@@ -0,0 +1,66 @@
+#ifndef KERNEL_OFFLOAD_HPP
+#define KERNEL_OFFLOAD_HPP
+
+/**
+ * @file kernel_offload.hpp
+ * @brief Programs the kernel thermal zone trips bound to the fan's cooling device
+ *
+ * On kernels built with CONFIG_THERMAL_WRITABLE_TRIPS the zone's own governor
+ * can follow our curve: the four trips bound to the fan are set to the LOW,
+ * MEDIUM, HIGH and FULL thresholds and their hysteresis, lowest trip first.
+ */
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class KernelOffload {
+public:
+    static constexpr size_t LEVEL_TRIPS = 4;
+
+    struct Stats {
+        bool available = false;
+        uint64_t total_trans = 0;
+        std::vector<uint64_t> time_in_state_ms;
+    };
+
+    ~KernelOffload();
+
+    // Locate the zone and writable trips for the cooling device owning fan_path
+    bool bind(const std::string& fan_path, std::string& error);
+
+    bool program(const std::array<double, LEVEL_TRIPS>& thresholds, double hysteresis);
+    bool verify() const;
+    void restore();
+
+    double zoneTemperature() const;
+    int coolingState() const;
+    Stats readStats() const;
+
+    const std::string& zonePath() const { return zone_path_; }
+    const std::string& coolingDevicePath() const { return cdev_path_; }
+
+private:
+    struct Trip {
+        int index = -1;
+        std::string temp_path;
+        std::string hyst_path;
+        bool hyst_writable = false;
+        std::string original_temp;
+        std::string original_hyst;
+        long programmed_temp = 0;
+        long programmed_hyst = 0;
+    };
+
+    std::string zone_path_;
+    std::string cdev_path_;
+    std::vector<Trip> trips_;
+    bool programmed_ = false;
+
+    static bool readValue(const std::string& path, std::string& value);
+    static bool writeValue(const std::string& path, const std::string& value);
+    static bool isWritable(const std::string& path);
+};
+
+#endif // KERNEL_OFFLOAD_HPP
@@ -0,0 +1,76 @@
+#ifndef POLICY_EXPRESSION_HPP
+#define POLICY_EXPRESSION_HPP
+
+/**
+ * @file policy_expression.hpp
+ * @brief Small expression language for fan policies, compiled to flat bytecode
+ *
+ * Grammar (lowest to highest precedence):
+ *   expr    := or ('?' expr ':' expr)?
+ *   or      := and ('||' and)*
+ *   and     := compare ('&&' compare)*
+ *   compare := sum (('<' | '<=' | '>' | '>=' | '==' | '!=') sum)?
+ *   sum     := product (('+' | '-') product)*
+ *   product := unary (('*' | '/') unary)*
+ *   unary   := ('-' | '!') unary | primary
+ *   primary := number | constant | variable | function '(' args ')' | '(' expr ')'
+ *
+ * Constants OFF, LOW, MEDIUM, HIGH and FULL evaluate to fan levels 0-4.
+ * Functions: min(a, b, ...), max(a, b, ...), clamp(x, lo, hi), abs(x), ladder(t).
+ * min/max ignore NaN operands, so a failed sensor drops out of the comparison.
+ * ladder(t) maps a temperature onto the configured thresholds with hysteresis.
+ *
+ * Both branches of '?:' are evaluated, so every program is straight-line code
+ * whose cost is bounded by its length and whose stack depth is known at compile time.
+ */
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Threshold set used by the ladder() builtin
+struct PolicyLadder {
+    std::array<double, 4> thresholds = {{54.0, 59.0, 64.0, 70.0}};
+    double hysteresis = 2.0;
+};
+
+class PolicyExpression {
+public:
+    static constexpr size_t MAX_STACK = 32;
+    static constexpr size_t MAX_INSTRUCTIONS = 256;
+
+    bool compile(const std::string& source, const std::vector<std::string>& variables,
+                 const PolicyLadder& ladder, std::string& error);
+    double evaluate(const double* variables, double current_level) const;
+
+    // Constants and function names, which variables must not shadow
+    static bool isReservedName(const std::string& name);
+
+    bool empty() const { return code_.empty(); }
+    size_t size() const { return code_.size(); }
+    const std::string& source() const { return source_; }
+
+private:
+    enum class Op : uint8_t {
+        PushConst, PushVar, Neg, Not,
+        Add, Sub, Mul, Div,
+        Lt, Le, Gt, Ge, Eq, Ne, And, Or,
+        Min, Max, Clamp, Abs, Ladder, Select
+    };
+
+    struct Instruction {
+        Op op;
+        uint32_t index;
+        double value;
+    };
+
+    std::vector<Instruction> code_;
+    std::string source_;
+    PolicyLadder ladder_;
+
+    class Compiler;
+    double ladderLevel(double temperature, double current_level) const;
+};
+
+#endif // POLICY_EXPRESSION_HPP
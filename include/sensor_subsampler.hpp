@@ -0,0 +1,80 @@
+#ifndef SENSOR_SUBSAMPLER_HPP
+#define SENSOR_SUBSAMPLER_HPP
+
+/**
+ * @file sensor_subsampler.hpp
+ * @brief Skips reads of sensors that are well predicted by another channel
+ *
+ * Pairwise means, variances and covariances are tracked as exponentially
+ * weighted moving statistics, together with the out-of-sample residual of
+ * predicting each channel from each other channel by linear regression.
+ * A channel whose best predictor is strongly correlated and accurate is read
+ * only every `factor` cycles and estimated in between; a check read whose
+ * residual exceeds the limit puts it back on full rate.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SensorSubsampler {
+public:
+    struct Settings {
+        int factor = 4;
+        double min_correlation = 0.98;
+        double max_residual = 0.5;
+        int warmup_samples = 40;
+        double decay = 0.05;
+    };
+
+    SensorSubsampler(const std::vector<std::string>& names, const Settings& settings);
+
+    // Decide which channels are read this cycle
+    void beginCycle();
+    bool shouldRead(size_t channel) const { return channels_[channel].read_this_cycle; }
+
+    // Take readings (NaN where skipped or failed) and fill in estimates for skipped channels
+    void complete(double* values);
+
+    // Mode changes since the last call, for logging
+    std::vector<std::string> takeEvents();
+    std::string report() const;
+
+private:
+    struct PairStats {
+        double samples = 0.0;
+        double mean_x = 0.0;
+        double mean_y = 0.0;
+        double var_x = 0.0;
+        double var_y = 0.0;
+        double cov = 0.0;
+        double residual_ms = 0.0;   // of predicting y from x
+    };
+
+    struct Channel {
+        std::string name;
+        int predictor = -1;          // >= 0 while subsampled
+        int phase = 0;
+        bool read_this_cycle = true;
+        uint64_t reads = 0;
+        uint64_t skipped = 0;
+        uint64_t checks = 0;
+        double abs_error_sum = 0.0;
+        double max_abs_error = 0.0;
+    };
+
+    Settings settings_;
+    std::vector<Channel> channels_;
+    std::vector<PairStats> pairs_;   // [x * n + y]: x predicts y
+    std::vector<std::string> events_;
+
+    PairStats& pair(size_t x, size_t y) { return pairs_[x * channels_.size() + y]; }
+    const PairStats& pair(size_t x, size_t y) const { return pairs_[x * channels_.size() + y]; }
+    double predict(size_t x, size_t y, double x_value) const;
+    double correlation(size_t x, size_t y) const;
+    void updatePair(size_t x, size_t y, double x_value, double y_value);
+    void considerReducing(size_t channel);
+};
+
+#endif // SENSOR_SUBSAMPLER_HPP
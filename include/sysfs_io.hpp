@@ -0,0 +1,76 @@
+#ifndef SYSFS_IO_HPP
+#define SYSFS_IO_HPP
+
+/**
+ * @file sysfs_io.hpp
+ * @brief Single path for the daemon's file, clock and sleep operations, with record/replay
+ *
+ * Live mode passes straight through to the system. Record mode additionally
+ * appends every operation (path id, op, result, errno, returned or written
+ * bytes, monotonic timestamp) to a compact binary log. Replay mode answers
+ * each operation from such a log instead of touching the system and runs
+ * on a virtual clock taken from the recorded timestamps, so a session from
+ * one node can be reproduced exactly anywhere.
+ *
+ * Log layout: "P5IO", version byte, start time (u64 µs, little endian),
+ * the command line arguments, then one record per operation:
+ *
+ *   op byte (| 0x20 errno follows, | 0x40 data follows)
+ *   varint time delta µs, varint path id (0 = none), zigzag varint result,
+ *   [errno byte], [varint prefix, varint suffix, varint length, bytes]
+ *
+ * Paths are sent once as a PATH record and numbered from 1. Data is stored
+ * as the part that differs from the previous data for the same path. A bare
+ * STOP op byte marks where a shutdown signal arrived.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+class SysfsIo {
+public:
+    // Recording starts before the configuration is read so replay sees the same files
+    static bool startRecording(const std::string& log_path, const std::vector<std::string>& arguments,
+                               std::string& error);
+    static bool startReplay(const std::string& log_path, std::vector<std::string>& arguments,
+                            std::string& error);
+    // Called where the recorded session was stopped, and when the log is exhausted or diverges
+    static void setReplayStopHandler(std::function<void()> handler);
+    // Async-signal-safe: mark the point where a shutdown was requested
+    static void recordStop();
+    static bool replayEnded();
+    // Flush the recording or report how far the replay got
+    static void finish();
+
+    static bool exists(const std::string& path);
+    static bool access(const std::string& path, int mode);
+    static int fileMode(const std::string& path);                 // st_mode, -1 on error
+    static int64_t modificationTime(const std::string& path);     // ns, -1 on error
+    // Whole file, or only its first max_bytes
+    static bool readFile(const std::string& path, std::string& contents, size_t max_bytes = 0);
+    static bool writeFile(const std::string& path, const std::string& value);
+    // Write to path.tmp and rename over path
+    static bool replaceFile(const std::string& path, const std::string& contents);
+    static bool listDirectory(const std::string& path, std::vector<std::string>& names);
+    static std::string canonical(const std::string& path);       // empty on error
+
+    static int open(const std::string& path, int flags);
+    static ssize_t write(int fd, const void* buf, size_t count);
+    static ssize_t pread(int fd, void* buf, size_t count, off_t offset);
+    static ssize_t pwrite(int fd, const void* buf, size_t count, off_t offset);
+    static int fsync(int fd);
+    static int close(int fd);
+
+    static double monotonic();
+    // Returns early when interrupted by a signal, like sleep(3)
+    static void sleep(double seconds);
+    // "NAME=value" entries whose NAME passes keep; only those are recorded
+    static std::vector<std::string> environment(const std::function<bool(const std::string&)>& keep);
+    static uint32_t randomSeed();
+    static long onlineCpus();
+};
+
+#endif // SYSFS_IO_HPP
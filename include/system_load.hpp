@@ -0,0 +1,38 @@
+#ifndef SYSTEM_LOAD_HPP
+#define SYSTEM_LOAD_HPP
+
+/**
+ * @file system_load.hpp
+ * @brief CPU utilisation and block I/O rate sampled from /proc
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class SystemLoad {
+public:
+    SystemLoad();
+
+    // Take a new sample; rates cover the time since the previous call
+    void update(double time_seconds);
+
+    double cpuLoad() const { return cpu_load_; }        // 0.0 - 1.0
+    double ioRate() const { return io_rate_mb_s_; }     // MB/s read + written
+
+private:
+    bool primed_;
+    double last_time_;
+    uint64_t last_cpu_total_;
+    uint64_t last_cpu_idle_;
+    uint64_t last_io_sectors_;
+    double cpu_load_;
+    double io_rate_mb_s_;
+    std::vector<std::string> disks_;
+
+    bool readCpuTimes(uint64_t& total, uint64_t& idle) const;
+    bool readIoSectors(uint64_t& sectors) const;
+    static std::vector<std::string> findWholeDisks();
+};
+
+#endif // SYSTEM_LOAD_HPP
@@ -0,0 +1,44 @@
+#ifndef TEMPERATURE_WINDOW_HPP
+#define TEMPERATURE_WINDOW_HPP
+
+/**
+ * @file temperature_window.hpp
+ * @brief Fixed-capacity rolling window of temperature samples
+ */
+
+#include <array>
+#include <cstddef>
+
+// Rolling statistics over the most recent samples, stored in place (no allocations)
+class TemperatureWindow {
+public:
+    static constexpr size_t MAX_SAMPLES = 64;
+
+    explicit TemperatureWindow(size_t capacity = 8);
+
+    void push(double time_seconds, double temperature);
+    void clear();
+
+    size_t size() const { return count_; }
+    size_t capacity() const { return capacity_; }
+
+    double mean() const;
+    double peak() const;
+    double minimum() const;
+    double slope() const;
+
+private:
+    struct Sample {
+        double time;
+        double value;
+    };
+
+    std::array<Sample, MAX_SAMPLES> samples_;
+    size_t capacity_;
+    size_t head_;
+    size_t count_;
+
+    const Sample& at(size_t index) const;
+};
+
+#endif // TEMPERATURE_WINDOW_HPP
@@ -0,0 +1,79 @@
+#ifndef THERMAL_SIMULATOR_HPP
+#define THERMAL_SIMULATOR_HPP
+
+/**
+ * @file thermal_simulator.hpp
+ * @brief Offline comparison of fan policies on a first-order thermal plant
+ *
+ * The SoC is modelled as a single heat capacity cooled towards ambient
+ * through a conductance that depends on the fan level:
+ *
+ *   C dT/dt = P(t) - G(level) (T - T_ambient)
+ *
+ * The heat input P(t) is either a reproducible synthetic workload or is
+ * recovered from a recorded trace by inverting the model over each interval
+ * with the recorded fan level, so the recorded history replays exactly.
+ */
+
+#include "fan_policy.hpp"
+#include "thermal_trace.hpp"
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+class ThermalSimulator {
+public:
+    struct Plant {
+        double ambient = 25.0;                                            // °C
+        double capacity = 60.0;                                           // J/K
+        std::array<double, 5> conductance = {0.12, 0.18, 0.22, 0.26, 0.30};  // W/K per fan level
+    };
+
+    struct Scorecard {
+        std::string policy;
+        double duration = 0.0;           // seconds
+        double fan_on_seconds = 0.0;
+        double level_seconds = 0.0;
+        uint64_t transitions = 0;
+        double peak_temperature = 0.0;
+        double overshoot_peak = 0.0;     // °C above FULL_THRESHOLD
+        double overshoot_integral = 0.0; // °C·s above FULL_THRESHOLD
+        uint64_t decisions = 0;
+        double ns_per_decision = 0.0;
+    };
+
+    ThermalSimulator(const FanControllerConfig& config, const Plant& plant);
+
+    // Reproducible mixed workload of the given length
+    void useSyntheticWorkload(double hours);
+    // Heat input recovered from a recorded trace; also enables the "recorded" row
+    void useTrace(const std::vector<ThermalTrace::Sample>& samples);
+
+    Scorecard run(FanPolicy& policy) const;
+    // The recorded fan levels played back against the same heat input
+    Scorecard runRecorded() const;
+
+    static void printScorecards(std::ostream& out, const std::vector<Scorecard>& cards);
+
+private:
+    struct Segment {
+        double end;      // seconds since start
+        double power;    // W
+        int level;       // recorded fan level, -1 for synthetic input
+    };
+
+    FanControllerConfig config_;
+    Plant plant_;
+    std::vector<Segment> segments_;
+    double initial_temperature_;
+    int initial_level_;
+
+    static constexpr double STEP_SECONDS = 0.05;
+
+    double steadyState(double power, int level) const;
+    void account(Scorecard& card, double temperature, int level, double dt) const;
+};
+
+#endif // THERMAL_SIMULATOR_HPP
@@ -0,0 +1,41 @@
+#ifndef THERMAL_TRACE_HPP
+#define THERMAL_TRACE_HPP
+
+/**
+ * @file thermal_trace.hpp
+ * @brief Temperature/fan level history format shared by importers and tools
+ *
+ * A trace is CSV with one sample per line:
+ *
+ *   node,time_s,temp_c,level
+ *   pi-rack3,1718012345.250000,61.500,2
+ *
+ * time_s is wall-clock seconds since the epoch with microsecond resolution,
+ * level is the fan level 0-4 in effect from that sample onwards.
+ */
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ThermalTrace {
+public:
+    static constexpr std::string_view HEADER = "node,time_s,temp_c,level\n";
+
+    struct Sample {
+        double time_s;
+        double temperature;
+        int level;
+    };
+
+    // Append one CSV record to out without intermediate allocations
+    static void appendRecord(std::string& out, std::string_view node, int64_t time_us,
+                             double temperature, int level);
+
+    // Read the samples of one node (the first node in the file when empty) in time order
+    static bool load(const std::string& path, std::string& node, std::vector<Sample>& samples,
+                     std::string& error);
+};
+
+#endif // THERMAL_TRACE_HPP
@@ -0,0 +1,93 @@
+#ifndef THRESHOLD_TUNER_HPP
+#define THRESHOLD_TUNER_HPP
+
+/**
+ * @file threshold_tuner.hpp
+ * @brief Online contextual bandit over small threshold and hysteresis offsets
+ *
+ * Each arm shifts all thresholds by one offset and the hysteresis by another.
+ * An arm runs for one epoch of control cycles; its reward penalises fan
+ * effort, level transitions and throttle events. The context is the idle
+ * temperature band (an ambient estimate) and CPU load band of the previous
+ * epoch. Arms are chosen by Thompson sampling from per-cell Gaussian
+ * posteriors, which persist in a small binary state file.
+ */
+
+#include "sysfs_io.hpp"
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+class ThresholdTuner {
+public:
+    struct Arm {
+        double threshold_offset;
+        double hysteresis_offset;
+    };
+
+    struct Settings {
+        std::vector<double> threshold_offsets;
+        std::vector<double> hysteresis_offsets;
+        int epoch_cycles = 240;
+        double interval_seconds = 15.0;
+        double base_full_threshold = 70.0;
+        double base_hysteresis = 2.0;
+        double throttle_temp = 80.0;
+        double safety_margin = 5.0;
+        double fan_weight = 1.0;
+        double transition_weight = 0.05;
+        double throttle_weight = 5.0;
+    };
+
+    bool initialize(const Settings& settings, std::string& error);
+    bool loadState(const std::string& path);
+    bool saveState(const std::string& path) const;
+
+    // Feed one control cycle; true when the epoch ended and a new arm was chosen
+    bool observe(double temperature, int level, double cpu_load);
+
+    const Arm& currentArm() const { return arms_[current_arm_]; }
+    const std::string& lastEpochSummary() const { return last_summary_; }
+    std::string bestArmsSummary() const;
+
+private:
+    static constexpr int AMBIENT_BANDS = 3;
+    static constexpr int LOAD_BANDS = 3;
+    static constexpr int CONTEXTS = AMBIENT_BANDS * LOAD_BANDS;
+
+    struct Cell {
+        float count = 0.0f;
+        float mean = 0.0f;
+        float m2 = 0.0f;
+    };
+
+    struct Epoch {
+        int cycles = 0;
+        double level_sum = 0.0;
+        int transitions = 0;
+        int throttle_events = 0;
+        int last_level = -1;
+        bool throttling = false;
+        double min_temp = 1e9;
+        double load_sum = 0.0;
+        bool aborted = false;
+    };
+
+    Settings settings_;
+    std::vector<Arm> arms_;
+    std::vector<Cell> cells_;   // CONTEXTS x arms, row-major by context
+    size_t current_arm_ = 0;
+    int context_ = 0;
+    Epoch epoch_;
+    std::string last_summary_;
+    std::mt19937 rng_{SysfsIo::randomSeed()};
+
+    static int contextFor(double idle_temp, double load);
+    static std::string contextName(int context);
+    std::string armName(size_t arm) const;
+    double rewardFor(const Epoch& epoch) const;
+    size_t selectArm(int context);
+};
+
+#endif // THRESHOLD_TUNER_HPP
@@ -0,0 +1,62 @@
+#ifndef VIRTUAL_SENSOR_HPP
+#define VIRTUAL_SENSOR_HPP
+
+/**
+ * @file virtual_sensor.hpp
+ * @brief Temperature estimates for unsensed components from a discrete thermal model
+ *
+ * Each sensor is a discrete-time state-space model fitted offline at the
+ * controller's INTERVAL_SECONDS:
+ *
+ *   x[k+1] = A x[k] + B u[k]
+ *   y[k]   = C x[k] + D u[k]
+ *
+ * with inputs u = [SoC °C, CPU load 0-1, I/O MB/s, fan level 0-4, 1].
+ * An RC network discretised at the same interval has exactly this form.
+ */
+
+#include "config_parser.hpp"
+#include <array>
+#include <cstddef>
+#include <string>
+
+class VirtualSensor {
+public:
+    static constexpr size_t MAX_STATES = 4;
+    static constexpr size_t INPUT_COUNT = 5;
+
+    enum Input : size_t {
+        INPUT_SOC_TEMP = 0,
+        INPUT_CPU_LOAD,
+        INPUT_IO_RATE,
+        INPUT_FAN_LEVEL,
+        INPUT_BIAS
+    };
+
+    using Inputs = std::array<double, INPUT_COUNT>;
+
+    bool configure(const VirtualSensorConfig& config, std::string& error);
+
+    // Return the estimate for this interval and advance the state
+    double update(const Inputs& inputs);
+
+    const std::string& name() const { return name_; }
+    bool fused() const { return fuse_; }
+    double value() const { return value_; }
+
+private:
+    std::string name_;
+    bool fuse_ = false;
+    bool initialized_ = false;
+    size_t states_ = 0;
+    std::array<double, MAX_STATES * MAX_STATES> a_{};
+    std::array<double, MAX_STATES * INPUT_COUNT> b_{};
+    std::array<double, MAX_STATES> c_{};
+    std::array<double, INPUT_COUNT> d_{};
+    std::array<double, MAX_STATES> x_{};
+    double value_ = 0.0;
+
+    void initializeSteadyState(const Inputs& inputs);
+};
+
+#endif // VIRTUAL_SENSOR_HPP
@@ -0,0 +1,239 @@
+/**
+ * @file cgroup_throttle.cpp
+ * @brief Implementation of cgroup v2 CPU throttling
+ */
+
+#include "cgroup_throttle.hpp"
+#include "sysfs_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <fcntl.h>
+
+CgroupThrottle::~CgroupThrottle() {
+    if (step_ != 0) {
+        for (const Group& group : groups_) {
+            writeFd(group.control_fd, group.original);
+        }
+    }
+    closeAll();
+}
+
+void CgroupThrottle::closeAll() {
+    for (Group& group : groups_) {
+        if (group.control_fd >= 0) {
+            SysfsIo::close(group.control_fd);
+        }
+        if (group.stat_fd >= 0) {
+            SysfsIo::close(group.stat_fd);
+        }
+        group.control_fd = -1;
+        group.stat_fd = -1;
+    }
+}
+
+bool CgroupThrottle::readFd(int fd, std::string& value) {
+    char buf[256];
+    ssize_t n = SysfsIo::pread(fd, buf, sizeof(buf) - 1, 0);
+    if (n < 0) {
+        return false;
+    }
+    value.assign(buf, static_cast<size_t>(n));
+    while (!value.empty() && (value.back() == '\n' || value.back() == ' ')) {
+        value.pop_back();
+    }
+    return true;
+}
+
+bool CgroupThrottle::writeFd(int fd, const std::string& value) {
+    // cgroupfs parses each write as a whole, so always write from offset 0
+    ssize_t n = SysfsIo::pwrite(fd, value.data(), value.size(), 0);
+    return n == static_cast<ssize_t>(value.size());
+}
+
+uint64_t CgroupThrottle::readStatUsec(int stat_fd, const char* field) {
+    if (stat_fd < 0) {
+        return 0;
+    }
+    char buf[1024];
+    ssize_t n = SysfsIo::pread(stat_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) {
+        return 0;
+    }
+    buf[n] = '\0';
+    // "key value" lines; match keys at line starts so one cannot match inside another
+    size_t length = std::strlen(field);
+    for (const char* line = buf; *line != '\0'; ) {
+        if (std::strncmp(line, field, length) == 0 && line[length] == ' ') {
+            return std::strtoull(line + length + 1, nullptr, 10);
+        }
+        const char* next = std::strchr(line, '\n');
+        if (next == nullptr) {
+            break;
+        }
+        line = next + 1;
+    }
+    return 0;
+}
+
+bool CgroupThrottle::open(const std::vector<std::string>& cgroup_paths, Mode mode,
+                          const std::vector<double>& steps) {
+    closeAll();
+    groups_.clear();
+    mode_ = mode;
+    steps_ = steps;
+    step_ = 0;
+    intervention_seconds_ = 0.0;
+    cpus_ = std::max(1L, SysfsIo::onlineCpus());
+
+    for (size_t i = 0; i < steps_.size(); i++) {
+        if (steps_[i] <= 0.0 || steps_[i] > 100.0 || (i > 0 && steps_[i] >= steps_[i - 1])) {
+            std::cerr << "Cgroup throttle steps must be decreasing percentages in (0, 100]" << std::endl;
+            return false;
+        }
+    }
+    if (steps_.empty()) {
+        std::cerr << "No cgroup throttle steps configured" << std::endl;
+        return false;
+    }
+
+    const char* control_name = (mode_ == Mode::MAX) ? "/cpu.max" : "/cpu.weight";
+    for (const std::string& path : cgroup_paths) {
+        Group group;
+        group.path = path;
+
+        std::string control_path = path + control_name;
+        group.control_fd = SysfsIo::open(control_path, O_RDWR | O_CLOEXEC);
+        if (group.control_fd < 0) {
+            std::cerr << "Failed to open " << control_path << ": " << std::strerror(errno) << std::endl;
+            groups_.push_back(group);
+            closeAll();
+            return false;
+        }
+        std::string stat_path = path + "/cpu.stat";
+        group.stat_fd = SysfsIo::open(stat_path, O_RDONLY | O_CLOEXEC);
+
+        if (!readFd(group.control_fd, group.original)) {
+            std::cerr << "Failed to read " << control_path << std::endl;
+            groups_.push_back(group);
+            closeAll();
+            return false;
+        }
+
+        std::istringstream iss(group.original);
+        if (mode_ == Mode::MAX) {
+            std::string quota;
+            iss >> quota >> group.period;
+            group.original_quota = (quota == "max") ? -1 : std::atoll(quota.c_str());
+            if (group.period <= 0) {
+                group.period = 100000;
+            }
+        } else {
+            iss >> group.original_weight;
+        }
+        groups_.push_back(group);
+    }
+    return true;
+}
+
+std::string CgroupThrottle::limitFor(const Group& group, double percent) const {
+    if (mode_ == Mode::WEIGHT) {
+        auto weight = static_cast<int64_t>(std::llround(group.original_weight * percent / 100.0));
+        return std::to_string(std::clamp<int64_t>(weight, 1, 10000));
+    }
+
+    auto quota = static_cast<int64_t>(group.period * cpus_ * percent / 100.0);
+    // Never loosen a limit the administrator already set
+    if (group.original_quota >= 0) {
+        quota = std::min(quota, group.original_quota);
+    }
+    quota = std::max<int64_t>(quota, 1000);
+    return std::to_string(quota) + " " + std::to_string(group.period);
+}
+
+bool CgroupThrottle::setStep(int step, double now_seconds) {
+    step = std::clamp(step, 0, stepCount());
+    if (step == step_) {
+        return true;
+    }
+
+    bool ok = true;
+    for (const Group& group : groups_) {
+        std::string value = (step == 0) ? group.original : limitFor(group, steps_[step - 1]);
+        if (!writeFd(group.control_fd, value)) {
+            std::cerr << "Failed to write '" << value << "' to " << group.path << ": "
+                      << std::strerror(errno) << std::endl;
+            ok = false;
+        }
+    }
+
+    if (step_ == 0 && step > 0) {
+        engaged_since_ = now_seconds;
+        for (Group& group : groups_) {
+            group.usage_usec_start = readStatUsec(group.stat_fd, "usage_usec");
+            group.throttled_usec_start = readStatUsec(group.stat_fd, "throttled_usec");
+        }
+    } else if (step_ > 0 && step == 0) {
+        intervention_seconds_ += now_seconds - engaged_since_;
+        for (Group& group : groups_) {
+            uint64_t usage = readStatUsec(group.stat_fd, "usage_usec");
+            uint64_t throttled = readStatUsec(group.stat_fd, "throttled_usec");
+            group.usage_usec_engaged += usage - std::min(usage, group.usage_usec_start);
+            group.throttled_usec_engaged += throttled - std::min(throttled, group.throttled_usec_start);
+        }
+    }
+    step_ = step;
+    return ok;
+}
+
+void CgroupThrottle::restore(double now_seconds) {
+    setStep(0, now_seconds);
+}
+
+double CgroupThrottle::interventionSeconds(double now_seconds) const {
+    double total = intervention_seconds_;
+    if (step_ > 0) {
+        total += now_seconds - engaged_since_;
+    }
+    return total;
+}
+
+double CgroupThrottle::usedCpuSecondsWhileLimited() const {
+    uint64_t total = 0;
+    for (const Group& group : groups_) {
+        total += group.usage_usec_engaged;
+        if (step_ > 0) {
+            uint64_t now = readStatUsec(group.stat_fd, "usage_usec");
+            total += now - std::min(now, group.usage_usec_start);
+        }
+    }
+    return total / 1e6;
+}
+
+double CgroupThrottle::outOfQuotaSeconds() const {
+    uint64_t total = 0;
+    for (const Group& group : groups_) {
+        total += group.throttled_usec_engaged;
+        if (step_ > 0) {
+            uint64_t now = readStatUsec(group.stat_fd, "throttled_usec");
+            total += now - std::min(now, group.throttled_usec_start);
+        }
+    }
+    return total / 1e6;
+}
+
+std::string CgroupThrottle::report(double now_seconds) const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1)
+        << "intervention " << interventionSeconds(now_seconds) << "s, used while limited "
+        << usedCpuSecondsWhileLimited() << " CPU-s";
+    if (mode_ == Mode::MAX) {
+        oss << ", out of quota " << outOfQuotaSeconds() << "s";
+    }
+    oss << " across " << groups_.size() << " cgroup(s)";
+    return oss.str();
+}
@@ -4,15 +4,11 @@
  */
 
 #include "config_parser.hpp"
-#include <fstream>
+#include "sysfs_io.hpp"
 #include <sstream>
 #include <cstdlib>
 #include <algorithm>
 #include <cctype>
-#include <filesystem>
-#include <dirent.h>
-
-namespace fs = std::filesystem;
 
 std::string ConfigParser::trim(const std::string& str) {
     size_t first = str.find_first_not_of(" \t");
@@ -23,14 +19,54 @@ std::string ConfigParser::trim(const std::string& str) {
     return str.substr(first, (last - first + 1));
 }
 
+bool ConfigParser::isConfigKey(const std::string& name) {
+    // Collected from applyKeyValues() itself so the two can never disagree; VSENSOR_
+    // keys depend on VIRTUAL_SENSORS and are matched by prefix
+    static const std::set<std::string> keys = [] {
+        std::set<std::string> looked_up;
+        FanControllerConfig scratch;
+        applyKeyValues({}, scratch, &looked_up);
+        return looked_up;
+    }();
+    return keys.count(name) != 0 || name.rfind("VSENSOR_", 0) == 0;
+}
+
+bool ConfigParser::parseBool(const std::string& value) {
+    std::string val = value;
+    std::transform(val.begin(), val.end(), val.begin(), ::tolower);
+    return val == "true" || val == "1" || val == "yes";
+}
+
+std::vector<std::string> ConfigParser::splitList(const std::string& value) {
+    std::vector<std::string> items;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        item = trim(item);
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<double> ConfigParser::parseDoubleList(const std::string& value) {
+    std::vector<double> numbers;
+    for (const std::string& item : splitList(value)) {
+        numbers.push_back(std::stod(item));
+    }
+    return numbers;
+}
+
 std::map<std::string, std::string> ConfigParser::parseKeyValueFile(const std::string& path) {
     std::map<std::string, std::string> result;
-    std::ifstream file(path);
+    std::string contents;
 
-    if (!file.is_open()) {
+    if (!SysfsIo::readFile(path, contents)) {
         return result;
     }
 
+    std::istringstream file(contents);
     std::string line;
     while (std::getline(file, line)) {
         // Skip comments and empty lines
@@ -57,32 +93,28 @@ std::map<std::string, std::string> ConfigParser::parseKeyValueFile(const std::st
 std::string ConfigParser::findHwmonDeviceByName(const std::string& device_name) {
     const std::string hwmon_base_path = "/sys/class/hwmon";
 
-    if (!fs::exists(hwmon_base_path)) {
+    std::vector<std::string> entries;
+    if (!SysfsIo::listDirectory(hwmon_base_path, entries)) {
         return "";
     }
 
-    for (const auto& entry : fs::directory_iterator(hwmon_base_path)) {
-        if (!entry.is_directory()) {
-            continue;
-        }
-
-        std::string entry_name = entry.path().filename().string();
+    for (const std::string& entry_name : entries) {
         if (entry_name.find("hwmon") != 0) {
             continue;
         }
 
-        std::string name_file = entry.path() / "name";
-        if (!fs::exists(name_file)) {
+        std::string entry_path = hwmon_base_path + "/" + entry_name;
+        std::string name_file = entry_path + "/name";
+        if (!SysfsIo::exists(name_file)) {
             continue;
         }
 
-        std::ifstream name_stream(name_file);
-        std::string name;
-        if (std::getline(name_stream, name)) {
-            name = trim(name);
+        std::string contents;
+        if (SysfsIo::readFile(name_file, contents) && !contents.empty()) {
+            std::string name = trim(contents.substr(0, contents.find('\n')));
             if (name == device_name) {
-                std::string temp_input = entry.path() / "temp1_input";
-                if (fs::exists(temp_input)) {
+                std::string temp_input = entry_path + "/temp1_input";
+                if (SysfsIo::exists(temp_input)) {
                     return temp_input;
                 }
             }
@@ -92,110 +124,151 @@ std::string ConfigParser::findHwmonDeviceByName(const std::string& device_name)
     return "";
 }
 
-FanControllerConfig ConfigParser::parseConfigFile(const std::string& config_path) {
-    FanControllerConfig config = getDefaultConfig();
-    auto kv_map = parseKeyValueFile(config_path);
+void ConfigParser::applyKeyValues(const std::map<std::string, std::string>& kv_map,
+                                  FanControllerConfig& config, std::set<std::string>* looked_up) {
+    auto find = [&kv_map, looked_up](const char* key) -> const std::string* {
+        if (looked_up != nullptr) {
+            looked_up->insert(key);
+        }
+        auto it = kv_map.find(key);
+        return it != kv_map.end() ? &it->second : nullptr;
+    };
+    const std::string* val;
 
-    if (kv_map.find("FAN_PATH") != kv_map.end()) {
-        config.fan_path = kv_map["FAN_PATH"];
+    if ((val = find("FAN_PATH")) != nullptr) {
+        config.fan_path = *val;
     }
-    if (kv_map.find("HWMON0_NAME") != kv_map.end()) {
-        config.hwmon0_name = kv_map["HWMON0_NAME"];
+    if ((val = find("HWMON0_NAME")) != nullptr) {
+        config.hwmon0_name = *val;
     }
-    if (kv_map.find("HWMON1_NAME") != kv_map.end()) {
-        config.hwmon1_name = kv_map["HWMON1_NAME"];
+    if ((val = find("HWMON1_NAME")) != nullptr) {
+        config.hwmon1_name = *val;
     }
-    if (kv_map.find("TEMP_HWMON0_PATH") != kv_map.end()) {
-        config.temp_hwmon0_path = kv_map["TEMP_HWMON0_PATH"];
+    if ((val = find("TEMP_HWMON0_PATH")) != nullptr) {
+        config.temp_hwmon0_path = *val;
     }
-    if (kv_map.find("TEMP_HWMON1_PATH") != kv_map.end()) {
-        config.temp_hwmon1_path = kv_map["TEMP_HWMON1_PATH"];
+    if ((val = find("TEMP_HWMON1_PATH")) != nullptr) {
+        config.temp_hwmon1_path = *val;
     }
-    if (kv_map.find("HYSTERESIS") != kv_map.end()) {
-        config.hysteresis = std::stod(kv_map["HYSTERESIS"]);
+    if ((val = find("HYSTERESIS")) != nullptr) {
+        config.hysteresis = std::stod(*val);
     }
-    if (kv_map.find("OFF_THRESHOLD") != kv_map.end()) {
-        config.off_threshold = std::stod(kv_map["OFF_THRESHOLD"]);
+    if ((val = find("OFF_THRESHOLD")) != nullptr) {
+        config.off_threshold = std::stod(*val);
     }
-    if (kv_map.find("LOW_THRESHOLD") != kv_map.end()) {
-        config.low_threshold = std::stod(kv_map["LOW_THRESHOLD"]);
+    if ((val = find("LOW_THRESHOLD")) != nullptr) {
+        config.low_threshold = std::stod(*val);
     }
-    if (kv_map.find("MEDIUM_THRESHOLD") != kv_map.end()) {
-        config.medium_threshold = std::stod(kv_map["MEDIUM_THRESHOLD"]);
+    if ((val = find("MEDIUM_THRESHOLD")) != nullptr) {
+        config.medium_threshold = std::stod(*val);
     }
-    if (kv_map.find("HIGH_THRESHOLD") != kv_map.end()) {
-        config.high_threshold = std::stod(kv_map["HIGH_THRESHOLD"]);
+    if ((val = find("HIGH_THRESHOLD")) != nullptr) {
+        config.high_threshold = std::stod(*val);
     }
-    if (kv_map.find("FULL_THRESHOLD") != kv_map.end()) {
-        config.full_threshold = std::stod(kv_map["FULL_THRESHOLD"]);
+    if ((val = find("FULL_THRESHOLD")) != nullptr) {
+        config.full_threshold = std::stod(*val);
     }
-    if (kv_map.find("INTERVAL_SECONDS") != kv_map.end()) {
-        config.interval_seconds = std::stoi(kv_map["INTERVAL_SECONDS"]);
+    if ((val = find("INTERVAL_SECONDS")) != nullptr) {
+        config.interval_seconds = std::stoi(*val);
     }
-    if (kv_map.find("DEBUG") != kv_map.end()) {
-        std::string val = kv_map["DEBUG"];
-        std::transform(val.begin(), val.end(), val.begin(), ::tolower);
-        config.debug = (val == "true" || val == "1" || val == "yes");
+    if ((val = find("DEBUG")) != nullptr) {
+        config.debug = parseBool(*val);
     }
-
-    // Find hwmon devices if paths not specified
-    if (config.temp_hwmon0_path.empty()) {
-        config.temp_hwmon0_path = findHwmonDeviceByName(config.hwmon0_name);
+    if ((val = find("POLICY_EXPR")) != nullptr) {
+        config.policy_expr = *val;
     }
-    if (config.temp_hwmon1_path.empty()) {
-        config.temp_hwmon1_path = findHwmonDeviceByName(config.hwmon1_name);
+    if ((val = find("POLICY_WINDOW")) != nullptr) {
+        config.policy_window = std::stoi(*val);
     }
+    if ((val = find("VIRTUAL_SENSORS")) != nullptr) {
+        config.virtual_sensors.clear();
+        for (const std::string& name : splitList(*val)) {
+            VirtualSensorConfig sensor;
+            sensor.name = name;
 
-    return config;
-}
-
-FanControllerConfig ConfigParser::parseEnvironment() {
-    FanControllerConfig config = getDefaultConfig();
-
-    const char* env_val;
-
-    if ((env_val = std::getenv("FAN_PATH")) != nullptr) {
-        config.fan_path = env_val;
+            std::string prefix = "VSENSOR_" + name + "_";
+            std::transform(prefix.begin(), prefix.end(), prefix.begin(), ::toupper);
+            const std::string* coeff;
+            if ((coeff = find((prefix + "A").c_str())) != nullptr) {
+                sensor.a = parseDoubleList(*coeff);
+            }
+            if ((coeff = find((prefix + "B").c_str())) != nullptr) {
+                sensor.b = parseDoubleList(*coeff);
+            }
+            if ((coeff = find((prefix + "C").c_str())) != nullptr) {
+                sensor.c = parseDoubleList(*coeff);
+            }
+            if ((coeff = find((prefix + "D").c_str())) != nullptr) {
+                sensor.d = parseDoubleList(*coeff);
+            }
+            if ((coeff = find((prefix + "FUSE").c_str())) != nullptr) {
+                sensor.fuse = parseBool(*coeff);
+            }
+            config.virtual_sensors.push_back(sensor);
+        }
+    }
+    if ((val = find("CGROUP_THROTTLE_PATHS")) != nullptr) {
+        config.cgroup_throttle_paths = splitList(*val);
+    }
+    if ((val = find("CGROUP_THROTTLE_MODE")) != nullptr) {
+        config.cgroup_throttle_mode = *val;
+        std::transform(config.cgroup_throttle_mode.begin(), config.cgroup_throttle_mode.end(),
+                       config.cgroup_throttle_mode.begin(), ::tolower);
+    }
+    if ((val = find("CGROUP_THROTTLE_STEPS")) != nullptr) {
+        config.cgroup_throttle_steps = parseDoubleList(*val);
+    }
+    if ((val = find("CGROUP_THROTTLE_TEMP")) != nullptr) {
+        config.cgroup_throttle_temp = std::stod(*val);
+    }
+    if ((val = find("CGROUP_THROTTLE_HYSTERESIS")) != nullptr) {
+        config.cgroup_throttle_hysteresis = std::stod(*val);
+    }
+    if ((val = find("KERNEL_OFFLOAD")) != nullptr) {
+        config.kernel_offload = parseBool(*val);
+    }
+    if ((val = find("KERNEL_OFFLOAD_SUPERVISE_SECONDS")) != nullptr) {
+        config.kernel_offload_supervise_seconds = std::stoi(*val);
     }
-    if ((env_val = std::getenv("HWMON0_NAME")) != nullptr) {
-        config.hwmon0_name = env_val;
+    if ((val = find("TUNER")) != nullptr) {
+        config.tuner = parseBool(*val);
     }
-    if ((env_val = std::getenv("HWMON1_NAME")) != nullptr) {
-        config.hwmon1_name = env_val;
+    if ((val = find("TUNER_STATE_PATH")) != nullptr) {
+        config.tuner_state_path = *val;
     }
-    if ((env_val = std::getenv("TEMP_HWMON0_PATH")) != nullptr) {
-        config.temp_hwmon0_path = env_val;
+    if ((val = find("TUNER_EPOCH_CYCLES")) != nullptr) {
+        config.tuner_epoch_cycles = std::stoi(*val);
     }
-    if ((env_val = std::getenv("TEMP_HWMON1_PATH")) != nullptr) {
-        config.temp_hwmon1_path = env_val;
+    if ((val = find("TUNER_OFFSETS")) != nullptr) {
+        config.tuner_offsets = parseDoubleList(*val);
     }
-    if ((env_val = std::getenv("HYSTERESIS")) != nullptr) {
-        config.hysteresis = std::stod(env_val);
+    if ((val = find("TUNER_HYSTERESIS_OFFSETS")) != nullptr) {
+        config.tuner_hysteresis_offsets = parseDoubleList(*val);
     }
-    if ((env_val = std::getenv("OFF_THRESHOLD")) != nullptr) {
-        config.off_threshold = std::stod(env_val);
+    if ((val = find("TUNER_THROTTLE_TEMP")) != nullptr) {
+        config.tuner_throttle_temp = std::stod(*val);
     }
-    if ((env_val = std::getenv("LOW_THRESHOLD")) != nullptr) {
-        config.low_threshold = std::stod(env_val);
+    if ((val = find("TUNER_SAFETY_MARGIN")) != nullptr) {
+        config.tuner_safety_margin = std::stod(*val);
     }
-    if ((env_val = std::getenv("MEDIUM_THRESHOLD")) != nullptr) {
-        config.medium_threshold = std::stod(env_val);
+    if ((val = find("TUNER_WEIGHTS")) != nullptr) {
+        config.tuner_weights = parseDoubleList(*val);
     }
-    if ((env_val = std::getenv("HIGH_THRESHOLD")) != nullptr) {
-        config.high_threshold = std::stod(env_val);
+    if ((val = find("SUBSAMPLE")) != nullptr) {
+        config.subsample = parseBool(*val);
     }
-    if ((env_val = std::getenv("FULL_THRESHOLD")) != nullptr) {
-        config.full_threshold = std::stod(env_val);
+    if ((val = find("SUBSAMPLE_FACTOR")) != nullptr) {
+        config.subsample_factor = std::stoi(*val);
     }
-    if ((env_val = std::getenv("INTERVAL_SECONDS")) != nullptr) {
-        config.interval_seconds = std::stoi(env_val);
+    if ((val = find("SUBSAMPLE_MIN_CORRELATION")) != nullptr) {
+        config.subsample_min_correlation = std::stod(*val);
     }
-    if ((env_val = std::getenv("DEBUG")) != nullptr) {
-        std::string val = env_val;
-        std::transform(val.begin(), val.end(), val.begin(), ::tolower);
-        config.debug = (val == "true" || val == "1" || val == "yes");
+    if ((val = find("SUBSAMPLE_MAX_RESIDUAL")) != nullptr) {
+        config.subsample_max_residual = std::stod(*val);
     }
+}
 
+void ConfigParser::resolveSensorPaths(FanControllerConfig& config) {
     // Find hwmon devices if paths not specified
     if (config.temp_hwmon0_path.empty()) {
         config.temp_hwmon0_path = findHwmonDeviceByName(config.hwmon0_name);
@@ -203,7 +276,31 @@ FanControllerConfig ConfigParser::parseEnvironment() {
     if (config.temp_hwmon1_path.empty()) {
         config.temp_hwmon1_path = findHwmonDeviceByName(config.hwmon1_name);
     }
+}
+
+FanControllerConfig ConfigParser::parseConfigFile(const std::string& config_path) {
+    FanControllerConfig config = getDefaultConfig();
+    config.config_path = config_path;
+    applyKeyValues(parseKeyValueFile(config_path), config);
+    resolveSensorPaths(config);
+    return config;
+}
+
+FanControllerConfig ConfigParser::parseEnvironment() {
+    FanControllerConfig config = getDefaultConfig();
+
+    // Only configuration keys are taken, so nothing else ends up in a recording
+    std::map<std::string, std::string> kv_map;
+    for (const std::string& entry : SysfsIo::environment(isConfigKey)) {
+        size_t eq_pos = entry.find('=');
+        if (eq_pos == std::string::npos || eq_pos == 0 || eq_pos + 1 == entry.size()) {
+            continue;
+        }
+        kv_map[entry.substr(0, eq_pos)] = entry.substr(eq_pos + 1);
+    }
 
+    applyKeyValues(kv_map, config);
+    resolveSensorPaths(config);
     return config;
 }
 
@@ -4,28 +4,69 @@
  */
 
 #include "fan_controller.hpp"
-#include <fstream>
+#include "sysfs_io.hpp"
 #include <sstream>
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <algorithm>
 #include <iomanip>
-#include <unistd.h>
+#include <limits>
 #include <fcntl.h>
-#include <filesystem>
-
-namespace fs = std::filesystem;
 
 FanController::FanController(const FanControllerConfig& config)
     : config_(config)
     , current_fan_speed_(FanSpeed::OFF)
     , running_(false)
+    , hwmon0_temp_(std::nan(""))
+    , hwmon1_temp_(std::nan(""))
+    , threshold_offset_(0.0)
+    , hysteresis_offset_(0.0)
+    , temp_window_(static_cast<size_t>(std::max(config.policy_window, 1)))
+    , config_mtime_(-1)
 {
 }
 
+namespace {
+
+// Slots of the built-in policy variables in policy_vars_
+enum PolicyVariable : size_t {
+    VAR_TEMP = 0,
+    VAR_HWMON0,
+    VAR_HWMON1,
+    VAR_MEAN,
+    VAR_PEAK,
+    VAR_SLOPE,
+    VAR_LEVEL,
+    VAR_BUILTIN_COUNT
+};
+
+const std::vector<std::string>& builtinPolicyVariables() {
+    static const std::vector<std::string> names = {
+        "temp", "hwmon0", "hwmon1", "mean", "peak", "slope", "level"
+    };
+    return names;
+}
+
+bool thresholdsAscending(const FanControllerConfig& config) {
+    return config.off_threshold < config.low_threshold &&
+           config.low_threshold < config.medium_threshold &&
+           config.medium_threshold < config.high_threshold &&
+           config.high_threshold < config.full_threshold;
+}
+
+// hwmon0 and hwmon1
+const size_t SENSOR_CHANNELS = 2;
+
+double monotonicSeconds() {
+    return SysfsIo::monotonic();
+}
+
+} // namespace
+
 bool FanController::initialize() {
     // Validate paths
-    if (!fs::exists(config_.fan_path)) {
+    if (!SysfsIo::exists(config_.fan_path)) {
         std::cerr << "Fan control file does not exist: " << config_.fan_path << std::endl;
         return false;
     }
@@ -39,14 +80,42 @@ bool FanController::initialize() {
     current_fan_speed_ = readFanSpeed();
 
     // Validate thresholds
-    if (config_.off_threshold >= config_.low_threshold ||
-        config_.low_threshold >= config_.medium_threshold ||
-        config_.medium_threshold >= config_.high_threshold ||
-        config_.high_threshold >= config_.full_threshold) {
+    if (!thresholdsAscending(config_)) {
         std::cerr << "Temperature thresholds not in ascending order" << std::endl;
         return false;
     }
 
+    if (!initializeVirtualSensors()) {
+        return false;
+    }
+
+    if (!compilePolicy()) {
+        return false;
+    }
+
+    if (!initializeCgroupThrottle()) {
+        return false;
+    }
+
+    if (!initializeTuner()) {
+        return false;
+    }
+
+    if (config_.subsample) {
+        if (config_.temp_hwmon0_path.empty() || config_.temp_hwmon1_path.empty()) {
+            logMessage("Sensor subsampling needs two sensors, reading every sensor each cycle");
+        } else {
+            SensorSubsampler::Settings settings;
+            settings.factor = config_.subsample_factor;
+            settings.min_correlation = config_.subsample_min_correlation;
+            settings.max_residual = config_.subsample_max_residual;
+            subsampler_ = std::make_unique<SensorSubsampler>(
+                std::vector<std::string>{"hwmon0", "hwmon1"}, settings);
+        }
+    }
+
+    initializeKernelOffload();
+
     std::string speed_name = fanSpeedToString(current_fan_speed_.load());
     std::string msg = "Fan controller initialized: current speed " + speed_name +
                       " (" + std::to_string(static_cast<int>(current_fan_speed_.load())) + "), "
@@ -58,24 +127,48 @@ bool FanController::initialize() {
                       "hysteresis=" + formatTemperature(config_.hysteresis) + "°C";
     logMessage(msg);
 
+    if (!policy_.empty()) {
+        logMessage("Using policy expression (" + std::to_string(policy_.size()) +
+                   " instructions): " + policy_.source());
+    }
+
     return true;
 }
 
 void FanController::run() {
     running_ = true;
 
+    if (kernel_offload_ && superviseKernelOffload()) {
+        return;
+    }
+
     while (running_) {
+        if (system_load_) {
+            system_load_->update(monotonicSeconds());
+        }
+
         double temp_average = getAverageTemperature();
 
         if (std::isnan(temp_average)) {
             logDebug("Failed to read temperature, skipping this cycle");
-            sleep(config_.interval_seconds);
+            SysfsIo::sleep(config_.interval_seconds);
             continue;
         }
 
-        FanSpeed target_speed = determineTargetSpeed(temp_average);
+        temp_window_.push(monotonicSeconds(), temp_average);
 
-        if (checkHysteresis(temp_average, target_speed)) {
+        // A policy expression owns the whole decision, including any hysteresis
+        FanSpeed target_speed;
+        bool allow_change;
+        if (policy_.empty()) {
+            target_speed = determineTargetSpeed(temp_average);
+            allow_change = checkHysteresis(temp_average, target_speed);
+        } else {
+            target_speed = evaluatePolicy(temp_average);
+            allow_change = true;
+        }
+
+        if (allow_change) {
             FanSpeed current_speed = current_fan_speed_.load();
             if (target_speed != current_speed) {
                 FanSpeed old_speed = current_speed;
@@ -98,7 +191,30 @@ void FanController::run() {
             logDebug(msg);
         }
 
-        sleep(config_.interval_seconds);
+        if (cgroup_throttle_) {
+            updateCgroupThrottle(temp_average);
+        }
+
+        if (tuner_) {
+            updateTuner(temp_average);
+        }
+
+        SysfsIo::sleep(config_.interval_seconds);
+    }
+
+    if (subsampler_) {
+        logMessage("Sensor subsampling: " + subsampler_->report());
+    }
+
+    if (tuner_) {
+        tuner_->saveState(config_.tuner_state_path);
+        logMessage("Tuner best arms: " + tuner_->bestArmsSummary());
+    }
+
+    if (cgroup_throttle_) {
+        double now = monotonicSeconds();
+        cgroup_throttle_->restore(now);
+        logMessage("Cgroup limits restored: " + cgroup_throttle_->report(now));
     }
 }
 
@@ -106,24 +222,30 @@ void FanController::stop() {
     running_ = false;
 }
 
+FanSpeed FanController::ladderDecision(double temperature, FanSpeed current_speed) {
+    current_fan_speed_.store(current_speed);
+    FanSpeed target_speed = determineTargetSpeed(temperature);
+    return checkHysteresis(temperature, target_speed) ? target_speed : current_speed;
+}
+
 double FanController::readTemperatureSensor(const std::string& temp_path) const {
-    if (!fs::exists(temp_path)) {
+    if (!SysfsIo::exists(temp_path)) {
         if (config_.debug) {
             logDebug("Temperature sensor path does not exist: " + temp_path);
         }
         return std::nan("");
     }
 
-    std::ifstream temp_file(temp_path);
-    if (!temp_file.is_open()) {
+    std::string temp_str;
+    if (!SysfsIo::readFile(temp_path, temp_str)) {
         if (config_.debug) {
             logDebug("Failed to open temperature sensor: " + temp_path);
         }
         return std::nan("");
     }
 
-    std::string temp_str;
-    if (!std::getline(temp_file, temp_str)) {
+    temp_str = temp_str.substr(0, temp_str.find('\n'));
+    if (temp_str.empty()) {
         if (config_.debug) {
             logDebug("Temperature sensor file is empty: " + temp_path);
         }
@@ -154,25 +276,40 @@ double FanController::readTemperatureSensor(const std::string& temp_path) const
     }
 }
 
-double FanController::getAverageTemperature() const {
+double FanController::getAverageTemperature() {
     std::vector<double> temps;
     std::vector<std::string> failed_sensors;
 
-    if (!config_.temp_hwmon0_path.empty()) {
-        double temp = readTemperatureSensor(config_.temp_hwmon0_path);
-        if (!std::isnan(temp)) {
-            temps.push_back(temp);
-        } else {
-            failed_sensors.push_back(config_.temp_hwmon0_path);
+    const std::string* paths[SENSOR_CHANNELS] = {&config_.temp_hwmon0_path, &config_.temp_hwmon1_path};
+    double readings[SENSOR_CHANNELS] = {std::nan(""), std::nan("")};
+
+    if (subsampler_) {
+        subsampler_->beginCycle();
+    }
+    for (size_t i = 0; i < SENSOR_CHANNELS; i++) {
+        if (!paths[i]->empty() && (!subsampler_ || subsampler_->shouldRead(i))) {
+            readings[i] = readTemperatureSensor(*paths[i]);
+        }
+    }
+    if (subsampler_) {
+        // Skipped channels come back as estimates from their predictor
+        subsampler_->complete(readings);
+        for (const std::string& event : subsampler_->takeEvents()) {
+            logMessage(event);
         }
     }
 
-    if (!config_.temp_hwmon1_path.empty()) {
-        double temp = readTemperatureSensor(config_.temp_hwmon1_path);
-        if (!std::isnan(temp)) {
-            temps.push_back(temp);
+    hwmon0_temp_ = readings[0];
+    hwmon1_temp_ = readings[1];
+
+    for (size_t i = 0; i < SENSOR_CHANNELS; i++) {
+        if (paths[i]->empty()) {
+            continue;
+        }
+        if (!std::isnan(readings[i])) {
+            temps.push_back(readings[i]);
         } else {
-            failed_sensors.push_back(config_.temp_hwmon1_path);
+            failed_sensors.push_back(*paths[i]);
         }
     }
 
@@ -181,6 +318,15 @@ double FanController::getAverageTemperature() const {
         return std::nan("");
     }
 
+    if (!virtual_sensors_.empty()) {
+        updateVirtualSensors(std::isnan(hwmon0_temp_) ? hwmon1_temp_ : hwmon0_temp_);
+        for (const VirtualSensor& sensor : virtual_sensors_) {
+            if (sensor.fused()) {
+                temps.push_back(sensor.value());
+            }
+        }
+    }
+
     if (!failed_sensors.empty()) {
         std::string msg = "Using " + std::to_string(temps.size()) + " sensor(s), " +
                          std::to_string(failed_sensors.size()) + " sensor(s) failed";
@@ -194,7 +340,419 @@ double FanController::getAverageTemperature() const {
     return sum / temps.size();
 }
 
+bool FanController::initializeVirtualSensors() {
+    if (config_.virtual_sensors.empty()) {
+        return true;
+    }
+
+    virtual_sensors_.clear();
+    for (const VirtualSensorConfig& sensor_config : config_.virtual_sensors) {
+        const auto& builtins = builtinPolicyVariables();
+        if (std::find(builtins.begin(), builtins.end(), sensor_config.name) != builtins.end()) {
+            std::cerr << "Virtual sensor name '" << sensor_config.name
+                      << "' clashes with a built-in variable" << std::endl;
+            return false;
+        }
+        if (PolicyExpression::isReservedName(sensor_config.name)) {
+            std::cerr << "Virtual sensor name '" << sensor_config.name
+                      << "' clashes with a policy constant or function" << std::endl;
+            return false;
+        }
+        for (const VirtualSensor& existing : virtual_sensors_) {
+            if (existing.name() == sensor_config.name) {
+                std::cerr << "Duplicate virtual sensor name: " << sensor_config.name << std::endl;
+                return false;
+            }
+        }
+
+        VirtualSensor sensor;
+        std::string error;
+        if (!sensor.configure(sensor_config, error)) {
+            std::cerr << "Invalid virtual sensor: " << error << std::endl;
+            return false;
+        }
+        virtual_sensors_.push_back(sensor);
+        logMessage("Virtual sensor " + sensor.name() + " configured" +
+                   (sensor.fused() ? " (fused into average)" : ""));
+    }
+
+    if (!system_load_) {
+        system_load_ = std::make_unique<SystemLoad>();
+    }
+    return true;
+}
+
+void FanController::updateVirtualSensors(double soc_temp) {
+    VirtualSensor::Inputs inputs = {};
+    inputs[VirtualSensor::INPUT_SOC_TEMP] = soc_temp;
+    inputs[VirtualSensor::INPUT_CPU_LOAD] = system_load_->cpuLoad();
+    inputs[VirtualSensor::INPUT_IO_RATE] = system_load_->ioRate();
+    inputs[VirtualSensor::INPUT_FAN_LEVEL] = static_cast<double>(current_fan_speed_.load());
+    inputs[VirtualSensor::INPUT_BIAS] = 1.0;
+
+    for (VirtualSensor& sensor : virtual_sensors_) {
+        double estimate = sensor.update(inputs);
+        if (config_.debug) {
+            logDebug("Virtual " + sensor.name() + ": " + formatTemperature(estimate) + "°C");
+        }
+    }
+}
+
+bool FanController::compilePolicy() {
+    if (config_.policy_expr.empty()) {
+        return true;
+    }
+
+    policy_var_names_ = builtinPolicyVariables();
+    for (const VirtualSensor& sensor : virtual_sensors_) {
+        policy_var_names_.push_back(sensor.name());
+    }
+    policy_vars_.assign(policy_var_names_.size(), std::nan(""));
+
+    PolicyLadder ladder;
+    ladder.thresholds = {{config_.low_threshold, config_.medium_threshold,
+                          config_.high_threshold, config_.full_threshold}};
+    ladder.hysteresis = config_.hysteresis;
+
+    std::string error;
+    if (!policy_.compile(config_.policy_expr, policy_var_names_, ladder, error)) {
+        std::cerr << "Invalid POLICY_EXPR: " << error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+FanSpeed FanController::evaluatePolicy(double temperature) {
+    FanSpeed current_speed = current_fan_speed_.load();
+
+    policy_vars_[VAR_TEMP] = temperature;
+    policy_vars_[VAR_HWMON0] = hwmon0_temp_;
+    policy_vars_[VAR_HWMON1] = hwmon1_temp_;
+    policy_vars_[VAR_MEAN] = temp_window_.mean();
+    policy_vars_[VAR_PEAK] = temp_window_.peak();
+    policy_vars_[VAR_SLOPE] = temp_window_.slope();
+    policy_vars_[VAR_LEVEL] = static_cast<double>(current_speed);
+    for (size_t i = 0; i < virtual_sensors_.size(); i++) {
+        policy_vars_[VAR_BUILTIN_COUNT + i] = virtual_sensors_[i].value();
+    }
+
+    double result = policy_.evaluate(policy_vars_.data(), static_cast<double>(current_speed));
+    if (std::isnan(result)) {
+        logDebug("Policy expression evaluated to NaN, keeping current speed");
+        return current_speed;
+    }
+
+    long level = std::lround(std::fmin(std::fmax(result, 0.0), 4.0));
+    return static_cast<FanSpeed>(level);
+}
+
+bool FanController::initializeCgroupThrottle() {
+    if (config_.cgroup_throttle_paths.empty()) {
+        return true;
+    }
+
+    CgroupThrottle::Mode mode;
+    if (config_.cgroup_throttle_mode == "max") {
+        mode = CgroupThrottle::Mode::MAX;
+    } else if (config_.cgroup_throttle_mode == "weight") {
+        mode = CgroupThrottle::Mode::WEIGHT;
+    } else {
+        std::cerr << "Invalid CGROUP_THROTTLE_MODE: " << config_.cgroup_throttle_mode
+                  << " (expected max or weight)" << std::endl;
+        return false;
+    }
+
+    cgroup_throttle_ = std::make_unique<CgroupThrottle>();
+    if (!cgroup_throttle_->open(config_.cgroup_throttle_paths, mode,
+                                config_.cgroup_throttle_steps)) {
+        cgroup_throttle_.reset();
+        return false;
+    }
+
+    logMessage("Cgroup throttling armed for " +
+               std::to_string(config_.cgroup_throttle_paths.size()) + " cgroup(s) above " +
+               formatTemperature(config_.cgroup_throttle_temp) + "°C at FULL, " +
+               std::to_string(cgroup_throttle_->stepCount()) + " step(s) on cpu." +
+               config_.cgroup_throttle_mode);
+    return true;
+}
+
+void FanController::updateCgroupThrottle(double temperature) {
+    int step = cgroup_throttle_->step();
+    int next = step;
+
+    // Tighten one step per cycle while the fan is maxed out and temperature is still climbing;
+    // relax one step per cycle once it has dropped below the hysteresis band
+    if (current_fan_speed_.load() == FanSpeed::FULL &&
+        temperature >= config_.cgroup_throttle_temp && temp_window_.slope() > 0.0) {
+        next = step + 1;
+    } else if (step > 0 &&
+               temperature <= config_.cgroup_throttle_temp - config_.cgroup_throttle_hysteresis) {
+        next = step - 1;
+    }
+
+    next = std::min(next, cgroup_throttle_->stepCount());
+    if (next == step) {
+        return;
+    }
+
+    double now = monotonicSeconds();
+    cgroup_throttle_->setStep(next, now);
+    std::string level = next == 0 ? std::string("off") :
+        formatTemperature(config_.cgroup_throttle_steps[next - 1]) + "%";
+    logMessage("T:" + formatTemperature(temperature) + "°C cgroup throttle " +
+               std::to_string(step) + " -> " + std::to_string(next) + " (" + level + "), " +
+               cgroup_throttle_->report(now));
+}
+
+bool FanController::initializeTuner() {
+    if (!config_.tuner) {
+        return true;
+    }
+    if (!policy_.empty()) {
+        logMessage("Threshold tuner disabled: POLICY_EXPR replaces the thresholds it tunes");
+        return true;
+    }
+
+    ThresholdTuner::Settings settings;
+    settings.threshold_offsets = config_.tuner_offsets;
+    settings.hysteresis_offsets = config_.tuner_hysteresis_offsets;
+    settings.epoch_cycles = config_.tuner_epoch_cycles;
+    settings.interval_seconds = config_.interval_seconds;
+    settings.base_full_threshold = config_.full_threshold;
+    settings.base_hysteresis = config_.hysteresis;
+    settings.throttle_temp = config_.tuner_throttle_temp;
+    settings.safety_margin = config_.tuner_safety_margin;
+    if (config_.tuner_weights.size() == 3) {
+        settings.fan_weight = config_.tuner_weights[0];
+        settings.transition_weight = config_.tuner_weights[1];
+        settings.throttle_weight = config_.tuner_weights[2];
+    } else {
+        std::cerr << "TUNER_WEIGHTS needs three values (fan, transitions, throttle)" << std::endl;
+        return false;
+    }
+
+    tuner_ = std::make_unique<ThresholdTuner>();
+    std::string error;
+    if (!tuner_->initialize(settings, error)) {
+        std::cerr << "Invalid tuner configuration: " << error << std::endl;
+        tuner_.reset();
+        return false;
+    }
+    bool restored = tuner_->loadState(config_.tuner_state_path);
+
+    if (!system_load_) {
+        system_load_ = std::make_unique<SystemLoad>();
+    }
+    threshold_offset_ = tuner_->currentArm().threshold_offset;
+    hysteresis_offset_ = tuner_->currentArm().hysteresis_offset;
+    logMessage(std::string("Threshold tuner enabled (") +
+               (restored ? "restored " : "new ") + config_.tuner_state_path + "), epochs of " +
+               std::to_string(config_.tuner_epoch_cycles) + " cycles, starting with threshold offset " +
+               formatTemperature(threshold_offset_) + "°C, hysteresis offset " +
+               formatTemperature(hysteresis_offset_) + "°C");
+    return true;
+}
+
+void FanController::updateTuner(double temperature) {
+    int level = static_cast<int>(current_fan_speed_.load());
+    if (!tuner_->observe(temperature, level, system_load_->cpuLoad())) {
+        return;
+    }
+
+    threshold_offset_ = tuner_->currentArm().threshold_offset;
+    hysteresis_offset_ = tuner_->currentArm().hysteresis_offset;
+    logMessage("Tuner: " + tuner_->lastEpochSummary());
+    tuner_->saveState(config_.tuner_state_path);
+}
+
+void FanController::initializeKernelOffload() {
+    if (!config_.kernel_offload) {
+        return;
+    }
+
+    // The kernel governor only sees its own zone sensor and the plain threshold curve
+    std::string reason;
+    if (!policy_.empty()) {
+        reason = "POLICY_EXPR cannot be evaluated by the kernel";
+    } else if (cgroup_throttle_) {
+        reason = "cgroup throttling needs the userspace loop";
+    } else if (tuner_) {
+        reason = "the threshold tuner needs the userspace loop";
+    }
+    for (const VirtualSensor& sensor : virtual_sensors_) {
+        if (sensor.fused() && reason.empty()) {
+            reason = "fused virtual sensor " + sensor.name() + " needs the userspace loop";
+        }
+    }
+
+    auto offload = std::make_unique<KernelOffload>();
+    if (reason.empty()) {
+        offload->bind(config_.fan_path, reason);
+    }
+    if (!reason.empty()) {
+        logMessage("Kernel offload unavailable, using polling loop: " + reason);
+        return;
+    }
+
+    kernel_offload_ = std::move(offload);
+    if (!programKernelTrips()) {
+        kernel_offload_.reset();
+        logMessage("Kernel offload unavailable, using polling loop: trip points did not verify");
+        return;
+    }
+
+    if (!config_.config_path.empty()) {
+        config_mtime_ = SysfsIo::modificationTime(config_.config_path);
+    }
+    offload_stats_ = kernel_offload_->readStats();
+}
+
+bool FanController::programKernelTrips() {
+    std::array<double, KernelOffload::LEVEL_TRIPS> thresholds = {{
+        config_.low_threshold, config_.medium_threshold,
+        config_.high_threshold, config_.full_threshold
+    }};
+    if (!kernel_offload_->program(thresholds, config_.hysteresis)) {
+        kernel_offload_->restore();
+        return false;
+    }
+    logMessage("Kernel offload: programmed " + kernel_offload_->zonePath() + " trips LOW>=" +
+               formatTemperature(config_.low_threshold) + "°C MEDIUM>=" +
+               formatTemperature(config_.medium_threshold) + "°C HIGH>=" +
+               formatTemperature(config_.high_threshold) + "°C FULL>=" +
+               formatTemperature(config_.full_threshold) + "°C, hysteresis=" +
+               formatTemperature(config_.hysteresis) + "°C");
+    return true;
+}
+
+bool FanController::reloadKernelOffloadConfig() {
+    int64_t mtime = SysfsIo::modificationTime(config_.config_path);
+    if (mtime < 0 || mtime == config_mtime_) {
+        return true;
+    }
+    config_mtime_ = mtime;
+
+    FanControllerConfig updated = ConfigParser::parseConfigFile(config_.config_path);
+    if (!updated.kernel_offload) {
+        logMessage("Kernel offload disabled in " + config_.config_path);
+        return false;
+    }
+    if (!thresholdsAscending(updated)) {
+        std::cerr << "Ignoring reloaded thresholds: not in ascending order" << std::endl;
+        return true;
+    }
+    if (updated.low_threshold == config_.low_threshold &&
+        updated.medium_threshold == config_.medium_threshold &&
+        updated.high_threshold == config_.high_threshold &&
+        updated.full_threshold == config_.full_threshold &&
+        updated.hysteresis == config_.hysteresis) {
+        return true;
+    }
+
+    config_.off_threshold = updated.off_threshold;
+    config_.low_threshold = updated.low_threshold;
+    config_.medium_threshold = updated.medium_threshold;
+    config_.high_threshold = updated.high_threshold;
+    config_.full_threshold = updated.full_threshold;
+    config_.hysteresis = updated.hysteresis;
+    config_.kernel_offload_supervise_seconds = updated.kernel_offload_supervise_seconds;
+    logMessage("Configuration changed, reprogramming trip points");
+    return programKernelTrips();
+}
+
+bool FanController::superviseKernelOffload() {
+    logMessage("Kernel offload active on " + kernel_offload_->coolingDevicePath() +
+               ", supervising every " +
+               std::to_string(std::max(config_.kernel_offload_supervise_seconds,
+                                       config_.interval_seconds)) + "s");
+
+    int mismatches = 0;
+    double last_temp = std::numeric_limits<double>::quiet_NaN();
+    while (running_) {
+        SysfsIo::sleep(std::max(config_.kernel_offload_supervise_seconds, config_.interval_seconds));
+        if (!running_) {
+            break;
+        }
+
+        if (!config_.config_path.empty() && !reloadKernelOffloadConfig()) {
+            break;
+        }
+        if (!kernel_offload_->verify()) {
+            logMessage("Kernel trip points changed externally, reprogramming");
+            if (!programKernelTrips()) {
+                break;
+            }
+        }
+
+        // The governor should hold a level inside the hysteresis band of the zone temperature.
+        // step_wise moves one state per polling delay, so it may still lag one state behind
+        // a rising or falling temperature
+        double temp = kernel_offload_->zoneTemperature();
+        int state = kernel_offload_->coolingState();
+        if (!std::isnan(temp) && state >= 0) {
+            int lowest = static_cast<int>(determineTargetSpeed(temp));
+            int highest = static_cast<int>(determineTargetSpeed(temp + config_.hysteresis));
+            if (temp > last_temp) {
+                lowest = std::max(lowest - 1, 0);
+            } else if (temp < last_temp) {
+                highest = std::min(highest + 1, 4);
+            }
+            last_temp = temp;
+
+            FanSpeed old_speed = current_fan_speed_.load();
+            FanSpeed speed = static_cast<FanSpeed>(std::clamp(state, 0, 4));
+            if (speed != old_speed) {
+                logMessage("T:" + formatTemperature(temp) + "°C S:" + fanSpeedToString(old_speed) +
+                           " -> " + fanSpeedToString(speed));
+            } else if (config_.debug) {
+                logDebug("T:" + formatTemperature(temp) + "°C S:" + fanSpeedToString(speed));
+            }
+            current_fan_speed_.store(speed);
+
+            if (state < lowest || state > highest) {
+                mismatches++;
+                logMessage("Kernel offload: cooling state " + std::to_string(state) + ", expected " +
+                           std::to_string(lowest) + "-" + std::to_string(highest));
+            } else {
+                mismatches = 0;
+            }
+        }
+        if (mismatches >= 3) {
+            logMessage("Kernel governor is not following the curve");
+            break;
+        }
+
+        KernelOffload::Stats stats = kernel_offload_->readStats();
+        if (stats.available && stats.total_trans != offload_stats_.total_trans) {
+            std::string msg = "Kernel offload: " +
+                              std::to_string(stats.total_trans - offload_stats_.total_trans) +
+                              " transition(s) since last check";
+            if (config_.debug && stats.time_in_state_ms.size() == offload_stats_.time_in_state_ms.size()) {
+                for (size_t i = 0; i < stats.time_in_state_ms.size(); i++) {
+                    msg += " " + fanSpeedToString(static_cast<FanSpeed>(std::min<size_t>(i, 4))) + "=" +
+                           std::to_string((stats.time_in_state_ms[i] -
+                                           offload_stats_.time_in_state_ms[i]) / 1000) + "s";
+                }
+            }
+            logMessage(msg);
+        }
+        offload_stats_ = stats;
+    }
+
+    kernel_offload_->restore();
+    kernel_offload_.reset();
+    if (!running_) {
+        return true;
+    }
+    logMessage("Kernel trip points restored, falling back to polling loop");
+    return false;
+}
+
 FanSpeed FanController::determineTargetSpeed(double temperature) const {
+    // Shifting every threshold up by the tuner offset is the same as shifting the reading down
+    temperature -= threshold_offset_;
+
     if (temperature >= config_.full_threshold) {
         return FanSpeed::FULL;
     } else if (temperature >= config_.high_threshold) {
@@ -209,7 +767,8 @@ FanSpeed FanController::determineTargetSpeed(double temperature) const {
 }
 
 bool FanController::checkHysteresis(double temperature, FanSpeed target_speed) const {
-    if (config_.hysteresis <= 0.0) {
+    double hysteresis = config_.hysteresis + hysteresis_offset_;
+    if (hysteresis <= 0.0) {
         return true;
     }
 
@@ -222,8 +781,8 @@ bool FanController::checkHysteresis(double temperature, FanSpeed target_speed) c
 
     // For speed decrease, check hysteresis
     if (target_speed < current_speed) {
-        double threshold = getThresholdForSpeed(target_speed);
-        return temperature <= (threshold - config_.hysteresis);
+        double threshold = getThresholdForSpeed(target_speed) + threshold_offset_;
+        return temperature <= (threshold - hysteresis);
     }
 
     return true;
@@ -256,14 +815,14 @@ bool FanController::setFanSpeed(FanSpeed speed) {
         return false;
     }
 
-    if (!fs::exists(config_.fan_path)) {
+    if (!SysfsIo::exists(config_.fan_path)) {
         std::cerr << "Fan control file does not exist: " << config_.fan_path << std::endl;
         return false;
     }
 
     try {
         // Use file descriptor directly for reliable write and sync
-        int fd = open(config_.fan_path.c_str(), O_WRONLY);
+        int fd = SysfsIo::open(config_.fan_path, O_WRONLY);
         if (fd < 0) {
             std::cerr << "Failed to open fan control file: " << config_.fan_path << std::endl;
             return false;
@@ -271,24 +830,24 @@ bool FanController::setFanSpeed(FanSpeed speed) {
 
         // Write speed value as string
         std::string speed_str = std::to_string(speed_value);
-        ssize_t written = write(fd, speed_str.c_str(), speed_str.length());
+        ssize_t written = SysfsIo::write(fd, speed_str.c_str(), speed_str.length());
         if (written < 0 || static_cast<size_t>(written) != speed_str.length()) {
             std::cerr << "Failed to write fan speed value" << std::endl;
-            close(fd);
+            SysfsIo::close(fd);
             return false;
         }
 
         // Sync to ensure write is committed
-        if (fsync(fd) != 0) {
+        if (SysfsIo::fsync(fd) != 0) {
             std::cerr << "Failed to sync fan speed write" << std::endl;
-            close(fd);
+            SysfsIo::close(fd);
             return false;
         }
 
-        close(fd);
+        SysfsIo::close(fd);
 
         // Small delay for hardware to process the change
-        usleep(200000); // 0.2 seconds
+        SysfsIo::sleep(0.2);
 
         if (!verifyFanSpeedWrite(speed)) {
             return false;
@@ -304,19 +863,19 @@ bool FanController::setFanSpeed(FanSpeed speed) {
 }
 
 FanSpeed FanController::readFanSpeed() const {
-    if (!fs::exists(config_.fan_path)) {
+    if (!SysfsIo::exists(config_.fan_path)) {
         std::cerr << "Fan control file does not exist: " << config_.fan_path << std::endl;
         return FanSpeed::OFF;
     }
 
-    std::ifstream fan_file(config_.fan_path);
-    if (!fan_file.is_open()) {
+    std::string speed_str;
+    if (!SysfsIo::readFile(config_.fan_path, speed_str)) {
         std::cerr << "Could not read current fan speed, starting with OFF" << std::endl;
         return FanSpeed::OFF;
     }
 
-    std::string speed_str;
-    if (!std::getline(fan_file, speed_str)) {
+    speed_str = speed_str.substr(0, speed_str.find('\n'));
+    if (speed_str.empty()) {
         std::cerr << "Fan control file is empty, starting with OFF" << std::endl;
         return FanSpeed::OFF;
     }
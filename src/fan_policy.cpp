@@ -0,0 +1,18 @@
+/**
+ * @file fan_policy.cpp
+ * @brief Implementation of the ladder policy adapter
+ */
+
+#include "fan_policy.hpp"
+#include <algorithm>
+
+LadderPolicy::LadderPolicy(const FanControllerConfig& config)
+    : controller_(config)
+    , interval_seconds_(std::max(config.interval_seconds, 1))
+{
+}
+
+int LadderPolicy::decide(double temperature, int current_level) {
+    FanSpeed current = static_cast<FanSpeed>(std::clamp(current_level, 0, 4));
+    return static_cast<int>(controller_.ladderDecision(temperature, current));
+}
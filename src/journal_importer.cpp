@@ -0,0 +1,406 @@
+/**
+ * @file journal_importer.cpp
+ * @brief Implementation of the journald export/JSON importer
+ */
+
+#include "journal_importer.hpp"
+#include "thermal_trace.hpp"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"OFF", "LOW", "MEDIUM", "HIGH", "FULL"};
+
+// Find the closing quote of a JSON string starting after the opening quote
+size_t findStringEnd(std::string_view data, size_t pos) {
+    while (pos < data.size()) {
+        const void* hit = std::memchr(data.data() + pos, '"', data.size() - pos);
+        if (hit == nullptr) {
+            return std::string_view::npos;
+        }
+        size_t quote = static_cast<const char*>(hit) - data.data();
+        size_t backslashes = 0;
+        while (quote - backslashes > pos && data[quote - backslashes - 1] == '\\') {
+            backslashes++;
+        }
+        if (backslashes % 2 == 0) {
+            return quote;
+        }
+        pos = quote + 1;
+    }
+    return std::string_view::npos;
+}
+
+// Skip a non-string JSON value (number, literal, array or object)
+size_t skipJsonValue(std::string_view data, size_t pos) {
+    int depth = 0;
+    while (pos < data.size()) {
+        char c = data[pos];
+        if (c == '"') {
+            pos = findStringEnd(data, pos + 1);
+            if (pos == std::string_view::npos) {
+                return pos;
+            }
+        } else if (c == '[' || c == '{') {
+            depth++;
+        } else if (c == ']' || c == '}') {
+            if (depth == 0) {
+                return pos;
+            }
+            depth--;
+        } else if (c == ',' && depth == 0) {
+            return pos;
+        }
+        pos++;
+    }
+    return pos;
+}
+
+} // namespace
+
+JournalImporter::JournalImporter(std::FILE* output)
+    : output_(output)
+{
+    buffer_.reserve(OUTPUT_BUFFER_SIZE + 256);
+    buffer_.append(ThermalTrace::HEADER);
+}
+
+bool JournalImporter::importFile(const std::string& path) {
+    auto start = std::chrono::steady_clock::now();
+
+    int fd = (path == "-") ? STDIN_FILENO : open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "Failed to open journal export: " << path << std::endl;
+        return false;
+    }
+
+    struct stat st;
+    bool ok = true;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t size = static_cast<size_t>(st.st_size);
+        void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            std::cerr << "Failed to map journal export: " << path << std::endl;
+            ok = false;
+        } else {
+            madvise(map, size, MADV_SEQUENTIAL);
+            parse(std::string_view(static_cast<const char*>(map), size), true);
+            munmap(map, size);
+            bytes_ += size;
+        }
+    } else {
+        // Pipes cannot be mapped; parse each chunk up to the last complete entry
+        // and carry the unfinished one over to the next read
+        std::string pending;
+        char chunk[1 << 16];
+        ssize_t n;
+        while ((n = read(fd, chunk, sizeof(chunk))) > 0) {
+            pending.append(chunk, static_cast<size_t>(n));
+            pending.erase(0, parse(pending, false));
+            bytes_ += static_cast<size_t>(n);
+        }
+        if (n < 0) {
+            std::cerr << "Failed to read journal export: " << path << std::endl;
+            ok = false;
+        }
+        parse(pending, true);
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+
+    elapsed_seconds_ += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return ok && !write_failed_;
+}
+
+bool JournalImporter::finish() {
+    flush();
+    if (std::fflush(output_) != 0) {
+        write_failed_ = true;
+    }
+    if (write_failed_) {
+        std::cerr << "Failed to write trace output" << std::endl;
+    }
+    return !write_failed_;
+}
+
+void JournalImporter::flush() {
+    if (buffer_.empty()) {
+        return;
+    }
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), output_) != buffer_.size()) {
+        write_failed_ = true;
+    }
+    buffer_.clear();
+}
+
+size_t JournalImporter::parse(std::string_view data, bool at_end) {
+    size_t first = data.find_first_not_of(" \t\r\n");
+    if (first == std::string_view::npos) {
+        return data.size();
+    }
+    if (data[first] == '{') {
+        return parseJson(data, at_end);
+    }
+    return parseExport(data, at_end);
+}
+
+size_t JournalImporter::parseExport(std::string_view data, bool at_end) {
+    // Entries are "KEY=value" lines separated by a blank line; fields holding
+    // binary data are "KEY\n" followed by a little-endian 64-bit size and the bytes
+    const char* base = data.data();
+    size_t size = data.size();
+    size_t pos = 0;
+
+    while (pos < size) {
+        std::string_view node, timestamp, message;
+        size_t entry_start = pos;
+        bool truncated = false;
+
+        while (pos < size && base[pos] != '\n') {
+            const void* nl_hit = std::memchr(base + pos, '\n', size - pos);
+            size_t nl = nl_hit ? static_cast<const char*>(nl_hit) - base : size;
+            if (nl == size && !at_end) {
+                truncated = true;
+                break;
+            }
+            const void* eq_hit = std::memchr(base + pos, '=', nl - pos);
+
+            std::string_view key, value;
+            if (eq_hit != nullptr) {
+                size_t eq = static_cast<const char*>(eq_hit) - base;
+                key = std::string_view(base + pos, eq - pos);
+                value = std::string_view(base + eq + 1, nl - eq - 1);
+                pos = nl + 1;
+            } else {
+                key = std::string_view(base + pos, nl - pos);
+                if (nl + 9 > size) {
+                    truncated = true;
+                    break;
+                }
+                uint64_t len = 0;
+                for (int i = 7; i >= 0; i--) {
+                    len = (len << 8) | static_cast<unsigned char>(base[nl + 1 + i]);
+                }
+                if (len > size - nl - 9) {
+                    truncated = true;
+                    break;
+                }
+                value = std::string_view(base + nl + 9, len);
+                pos = nl + 9 + len + 1;
+            }
+
+            if (key == "MESSAGE") {
+                message = value;
+            } else if (key == "_HOSTNAME") {
+                node = value;
+            } else if (key == "__REALTIME_TIMESTAMP") {
+                timestamp = value;
+            }
+        }
+        if (!at_end && (truncated || pos >= size)) {
+            // Wait for the rest of the entry and its terminating blank line
+            return entry_start;
+        }
+        if (truncated) {
+            pos = size;
+        }
+        pos++;  // blank line terminating the entry
+
+        if (!message.empty()) {
+            handleEntry(node, timestamp, message);
+        }
+    }
+    return size;
+}
+
+size_t JournalImporter::parseJson(std::string_view data, bool at_end) {
+    // One object per line; values are kept escaped, which the message
+    // parser tolerates because the fields it reads are plain ASCII
+    size_t pos = 0;
+    while (pos < data.size()) {
+        size_t end = data.find('\n', pos);
+        if (end == std::string_view::npos) {
+            if (!at_end) {
+                return pos;
+            }
+            end = data.size();
+        }
+        std::string_view line = data.substr(pos, end - pos);
+        pos = end + 1;
+
+        std::string_view node, timestamp, message;
+        size_t i = line.find('{');
+        if (i == std::string_view::npos) {
+            continue;
+        }
+        i++;
+
+        while (i < line.size()) {
+            size_t key_start = line.find('"', i);
+            if (key_start == std::string_view::npos) {
+                break;
+            }
+            size_t key_end = findStringEnd(line, key_start + 1);
+            if (key_end == std::string_view::npos) {
+                break;
+            }
+            std::string_view key = line.substr(key_start + 1, key_end - key_start - 1);
+
+            size_t colon = line.find(':', key_end + 1);
+            if (colon == std::string_view::npos) {
+                break;
+            }
+            i = line.find_first_not_of(" \t", colon + 1);
+            if (i == std::string_view::npos) {
+                break;
+            }
+
+            if (line[i] == '"') {
+                size_t value_end = findStringEnd(line, i + 1);
+                if (value_end == std::string_view::npos) {
+                    break;
+                }
+                std::string_view value = line.substr(i + 1, value_end - i - 1);
+                if (key == "MESSAGE") {
+                    message = value;
+                } else if (key == "_HOSTNAME") {
+                    node = value;
+                } else if (key == "__REALTIME_TIMESTAMP") {
+                    timestamp = value;
+                }
+                i = value_end + 1;
+            } else {
+                i = skipJsonValue(line, i);
+            }
+        }
+
+        if (!message.empty()) {
+            handleEntry(node, timestamp, message);
+        }
+    }
+    return data.size();
+}
+
+int JournalImporter::parseLevel(std::string_view name) {
+    for (int level = 0; level < 5; level++) {
+        if (name == LEVEL_NAMES[level]) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+bool JournalImporter::parseMessage(std::string_view message, double& temperature,
+                                   int& from_level, int& to_level) {
+    // "T:<temp>°C S:<level>" optionally followed by " -> <level>"
+    if (message.size() < 6 || message[0] != 'T' || message[1] != ':') {
+        return false;
+    }
+    const char* begin = message.data() + 2;
+    const char* end = message.data() + message.size();
+    auto result = std::from_chars(begin, end, temperature);
+    if (result.ec != std::errc()) {
+        return false;
+    }
+
+    std::string_view rest(result.ptr, static_cast<size_t>(end - result.ptr));
+    size_t s_pos = rest.find(" S:");
+    if (s_pos == std::string_view::npos) {
+        return false;
+    }
+    rest.remove_prefix(s_pos + 3);
+
+    size_t arrow = rest.find(" -> ");
+    if (arrow == std::string_view::npos) {
+        from_level = to_level = parseLevel(rest);
+    } else {
+        from_level = parseLevel(rest.substr(0, arrow));
+        to_level = parseLevel(rest.substr(arrow + 4));
+    }
+    return from_level >= 0 && to_level >= 0;
+}
+
+void JournalImporter::handleEntry(std::string_view node, std::string_view timestamp,
+                                  std::string_view message) {
+    double temperature = 0.0;
+    int from_level = 0, to_level = 0;
+    int64_t time_us = 0;
+    if (!parseMessage(message, temperature, from_level, to_level) ||
+        std::from_chars(timestamp.data(), timestamp.data() + timestamp.size(),
+                        time_us).ec != std::errc()) {
+        skipped_++;
+        return;
+    }
+    if (node.empty()) {
+        node = "unknown";
+    }
+    controller_lines_++;
+
+    auto it = nodes_.find(node);
+    if (it == nodes_.end()) {
+        it = nodes_.emplace(std::string(node), NodeTimeline()).first;
+        it->second.first_us = time_us;
+        it->second.last_us = time_us;
+    }
+    NodeTimeline& timeline = it->second;
+
+    if (timeline.level >= 0 && time_us >= timeline.last_us) {
+        timeline.level_seconds[timeline.level] += (time_us - timeline.last_us) / 1e6;
+    }
+    if (from_level != to_level) {
+        timeline.transitions++;
+        // A transition that does not start where the previous one ended means lost lines
+        if (timeline.level >= 0 && timeline.level != from_level) {
+            timeline.gaps++;
+        }
+    }
+    timeline.level = to_level;
+    timeline.last_us = std::max(timeline.last_us, time_us);
+    timeline.first_us = std::min(timeline.first_us, time_us);
+    timeline.samples++;
+
+    ThermalTrace::appendRecord(buffer_, node, time_us, temperature, to_level);
+    if (buffer_.size() >= OUTPUT_BUFFER_SIZE) {
+        flush();
+    }
+}
+
+void JournalImporter::printSummary(std::ostream& out) const {
+    double mb = bytes_ / 1e6;
+    out << "Imported " << std::fixed << std::setprecision(1) << mb << " MB in "
+        << std::setprecision(3) << elapsed_seconds_ << " s";
+    if (elapsed_seconds_ > 0.0) {
+        out << " (" << std::setprecision(1) << mb / elapsed_seconds_ << " MB/s)";
+    }
+    out << ": " << controller_lines_ << " controller lines, " << skipped_ << " other entries skipped, "
+        << nodes_.size() << " node(s)\n";
+
+    for (const auto& [name, timeline] : nodes_) {
+        double span = (timeline.last_us - timeline.first_us) / 1e6;
+        out << "  " << name << ": " << timeline.samples << " samples, "
+            << timeline.transitions << " transitions, " << timeline.gaps << " gaps, "
+            << std::setprecision(1) << span / 3600.0 << " h";
+        if (span > 0.0) {
+            out << " [";
+            for (int level = 0; level < 5; level++) {
+                out << (level ? " " : "") << LEVEL_NAMES[level] << " "
+                    << std::setprecision(1) << 100.0 * timeline.level_seconds[level] / span << "%";
+            }
+            out << "]";
+        }
+        out << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
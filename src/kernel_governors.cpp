@@ -0,0 +1,165 @@
+/**
+ * @file kernel_governors.cpp
+ * @brief Implementation of the kernel thermal governor emulations
+ */
+
+#include "kernel_governors.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+GovernorZone GovernorZone::fromConfig(const FanControllerConfig& config, double polling_delay) {
+    GovernorZone zone;
+    const double thresholds[] = {config.low_threshold, config.medium_threshold, config.high_threshold,
+                                 config.full_threshold};
+    for (int i = 0; i < 4; i++) {
+        zone.trips.push_back({thresholds[i], config.hysteresis, i + 1, i + 1});
+    }
+    zone.polling_delay = polling_delay;
+    zone.passive_delay = polling_delay;
+    return zone;
+}
+
+// step_wise
+
+StepWiseGovernor::StepWiseGovernor(const GovernorZone& zone)
+    : zone_(zone)
+{
+    reset();
+}
+
+void StepWiseGovernor::reset() {
+    instances_.clear();
+    for (const GovernorZone::Trip& trip : zone_.trips) {
+        Instance instance;
+        instance.threshold = trip.temperature;
+        instances_.push_back(instance);
+    }
+    // The zone starts from THERMAL_TEMP_INIT, so the first update sees a rising trend
+    last_temperature_ = -std::numeric_limits<double>::infinity();
+}
+
+int StepWiseGovernor::decide(double temperature, int current_level) {
+    enum Trend { STABLE, RAISING, DROPPING };
+    Trend trend = temperature > last_temperature_ ? RAISING
+                : temperature < last_temperature_ ? DROPPING : STABLE;
+
+    for (size_t i = 0; i < instances_.size(); i++) {
+        const GovernorZone::Trip& trip = zone_.trips[i];
+        Instance& instance = instances_[i];
+
+        // handle_thermal_trip(): move the threshold down by the hysteresis once crossed
+        if (last_temperature_ < instance.threshold) {
+            if (temperature >= trip.temperature) {
+                instance.threshold = trip.temperature - trip.hysteresis;
+            }
+        } else if (temperature < instance.threshold) {
+            instance.threshold = trip.temperature;
+        }
+
+        bool throttle = temperature >= instance.threshold;
+        int target = instance.target;
+        if (!instance.initialized) {
+            target = throttle ? std::clamp(current_level + 1, trip.lower, trip.upper) : NO_TARGET;
+        } else if (throttle) {
+            if (trend == RAISING) {
+                target = std::clamp(current_level + 1, trip.lower, trip.upper);
+            }
+        } else if (trend == DROPPING) {
+            target = current_level <= trip.lower ? NO_TARGET
+                                                 : std::clamp(current_level - 1, trip.lower, trip.upper);
+        }
+
+        if (!instance.initialized || target != instance.target) {
+            instance.target = target;
+            instance.initialized = true;
+        }
+    }
+    last_temperature_ = temperature;
+
+    // thermal_cdev_update(): the deepest requested state wins, no target counts as 0
+    int state = 0;
+    for (const Instance& instance : instances_) {
+        state = std::max(state, instance.target);
+    }
+    return std::min(state, zone_.max_state);
+}
+
+// bang_bang
+
+BangBangGovernor::BangBangGovernor(const GovernorZone& zone)
+    : zone_(zone)
+{
+    reset();
+}
+
+void BangBangGovernor::reset() {
+    targets_.assign(zone_.trips.size(), 0);
+}
+
+int BangBangGovernor::decide(double temperature, int) {
+    int state = 0;
+    for (size_t i = 0; i < zone_.trips.size(); i++) {
+        const GovernorZone::Trip& trip = zone_.trips[i];
+        if (targets_[i] == 0 && temperature >= trip.temperature) {
+            targets_[i] = 1;
+        } else if (targets_[i] == 1 && temperature <= trip.temperature - trip.hysteresis) {
+            targets_[i] = 0;
+        }
+        state = std::max(state, targets_[i]);
+    }
+    return state;
+}
+
+// power_allocator
+
+PowerAllocatorGovernor::PowerAllocatorGovernor(const GovernorZone& zone, double sustainable_power)
+    : zone_(zone)
+    , switch_on_temp_(zone.trips.front().temperature)
+    , control_temp_(zone.trips.back().temperature)
+    , sustainable_power_(sustainable_power)
+    , max_power_(2.0 * sustainable_power)
+    , integral_cutoff_(0.0)
+    , err_integral_(0.0)
+{
+    // estimate_pid_constants() defaults; k_i is the fixed int_to_frac(10) / 1000 mW/m°C,
+    // i.e. 10 mW/°C in the units used here, independent of the temperature range
+    double temperature_range = std::max(control_temp_ - switch_on_temp_, 1.0);
+    k_po_ = sustainable_power_ / temperature_range;
+    k_pu_ = 2.0 * sustainable_power_ / temperature_range;
+    k_i_ = 10.0;
+}
+
+double PowerAllocatorGovernor::pollInterval(double temperature) const {
+    return temperature >= switch_on_temp_ ? zone_.passive_delay : zone_.polling_delay;
+}
+
+void PowerAllocatorGovernor::reset() {
+    err_integral_ = 0.0;
+}
+
+int PowerAllocatorGovernor::decide(double temperature, int) {
+    // Below switch-on the PID is reset and every actor gets maximum power
+    if (temperature < switch_on_temp_) {
+        reset();
+        return 0;
+    }
+
+    // pid_controller(); k_d defaults to 0 so the derivative term is omitted
+    double err = control_temp_ - temperature;
+    double p = (err < 0.0 ? k_po_ : k_pu_) * err;
+    double i = k_i_ * err_integral_;
+    if (err < integral_cutoff_) {
+        double i_next = i + k_i_ * err;
+        if (std::fabs(i_next) < max_power_) {
+            i = i_next;
+            err_integral_ += err;
+        }
+    }
+    double granted = std::clamp(sustainable_power_ + p + i, 0.0, max_power_);
+
+    // The fan is modelled as the inverse of a power actor: the less power is granted
+    // to the heat source, the deeper the cooling state, rounded towards more cooling
+    double state = zone_.max_state * (1.0 - granted / max_power_);
+    return std::clamp(static_cast<int>(std::ceil(state - 1e-9)), 0, zone_.max_state);
+}
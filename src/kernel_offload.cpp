@@ -0,0 +1,251 @@
+/**
+ * @file kernel_offload.cpp
+ * @brief Implementation of thermal zone trip programming
+ */
+
+#include "kernel_offload.hpp"
+#include "sysfs_io.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <sstream>
+#include <filesystem>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char* const THERMAL_BASE_PATH = "/sys/class/thermal";
+
+bool isCdevLink(const std::string& name) {
+    // Matches "cdevN" but not "cdevN_trip_point" / "cdevN_weight"
+    if (name.rfind("cdev", 0) != 0 || name.size() == 4) {
+        return false;
+    }
+    return std::all_of(name.begin() + 4, name.end(), ::isdigit);
+}
+
+} // namespace
+
+KernelOffload::~KernelOffload() {
+    restore();
+}
+
+bool KernelOffload::readValue(const std::string& path, std::string& value) {
+    if (!SysfsIo::readFile(path, value) || value.empty()) {
+        return false;
+    }
+    value = value.substr(0, value.find('\n'));
+    return true;
+}
+
+bool KernelOffload::writeValue(const std::string& path, const std::string& value) {
+    return SysfsIo::writeFile(path, value);
+}
+
+bool KernelOffload::isWritable(const std::string& path) {
+    // Without CONFIG_THERMAL_WRITABLE_TRIPS the attributes are created read-only (0444)
+    int mode = SysfsIo::fileMode(path);
+    if (mode < 0) {
+        return false;
+    }
+    return (mode & (S_IWUSR | S_IWGRP | S_IWOTH)) != 0 && SysfsIo::access(path, W_OK);
+}
+
+bool KernelOffload::bind(const std::string& fan_path, std::string& error) {
+    cdev_path_ = SysfsIo::canonical(fs::path(fan_path).parent_path().string());
+    if (cdev_path_.empty()) {
+        error = "cannot resolve cooling device for " + fan_path;
+        return false;
+    }
+
+    std::vector<std::string> zones;
+    if (!SysfsIo::listDirectory(THERMAL_BASE_PATH, zones)) {
+        error = std::string(THERMAL_BASE_PATH) + " does not exist";
+        return false;
+    }
+
+    trips_.clear();
+    for (const std::string& zone_name : zones) {
+        if (zone_name.rfind("thermal_zone", 0) != 0) {
+            continue;
+        }
+        fs::path zone = fs::path(THERMAL_BASE_PATH) / zone_name;
+        std::vector<std::string> entries;
+        SysfsIo::listDirectory(zone.string(), entries);
+        for (const std::string& name : entries) {
+            if (!isCdevLink(name) || SysfsIo::canonical((zone / name).string()) != cdev_path_) {
+                continue;
+            }
+
+            std::string index_str;
+            if (!readValue((zone / (name + "_trip_point")).string(), index_str)) {
+                continue;
+            }
+            Trip trip;
+            trip.index = std::atoi(index_str.c_str());
+            std::string prefix = (zone / ("trip_point_" + std::to_string(trip.index))).string();
+            trip.temp_path = prefix + "_temp";
+            trip.hyst_path = prefix + "_hyst";
+
+            bool duplicate = std::any_of(trips_.begin(), trips_.end(),
+                                         [&](const Trip& t) { return t.index == trip.index; });
+            if (!duplicate) {
+                trips_.push_back(trip);
+            }
+        }
+        if (!trips_.empty()) {
+            zone_path_ = zone.string();
+            break;
+        }
+    }
+
+    if (trips_.empty()) {
+        error = "no thermal zone is bound to " + cdev_path_;
+        return false;
+    }
+
+    // Only step_wise moves the fan one state per trip crossed; other governors ignore the curve
+    std::string policy;
+    if (!readValue(zone_path_ + "/policy", policy)) {
+        error = "cannot read " + zone_path_ + "/policy";
+        trips_.clear();
+        return false;
+    }
+    if (policy != "step_wise") {
+        error = zone_path_ + " uses the " + policy + " governor, step_wise is needed to follow the trips";
+        trips_.clear();
+        return false;
+    }
+    if (trips_.size() != LEVEL_TRIPS) {
+        error = zone_path_ + " binds " + std::to_string(trips_.size()) + " trip(s) to the fan, " +
+                std::to_string(LEVEL_TRIPS) + " are needed to express the curve";
+        trips_.clear();
+        return false;
+    }
+
+    for (Trip& trip : trips_) {
+        if (!readValue(trip.temp_path, trip.original_temp)) {
+            error = "cannot read " + trip.temp_path;
+            trips_.clear();
+            return false;
+        }
+        if (!isWritable(trip.temp_path)) {
+            error = trip.temp_path + " is not writable (kernel lacks CONFIG_THERMAL_WRITABLE_TRIPS?)";
+            trips_.clear();
+            return false;
+        }
+        trip.hyst_writable = readValue(trip.hyst_path, trip.original_hyst) &&
+                             isWritable(trip.hyst_path);
+    }
+
+    // The lowest trip drives LOW, the highest FULL
+    std::sort(trips_.begin(), trips_.end(), [](const Trip& a, const Trip& b) {
+        return std::atol(a.original_temp.c_str()) < std::atol(b.original_temp.c_str());
+    });
+    return true;
+}
+
+bool KernelOffload::program(const std::array<double, LEVEL_TRIPS>& thresholds, double hysteresis) {
+    if (trips_.empty()) {
+        return false;
+    }
+
+    // Move the whole set in one direction so trips never cross while being rewritten
+    long current_low = std::atol(trips_.front().original_temp.c_str());
+    if (programmed_) {
+        current_low = trips_.front().programmed_temp;
+    }
+    long new_low = std::lround(thresholds[0] * 1000.0);
+    bool top_down = new_low > current_low;
+
+    bool ok = true;
+    for (size_t n = 0; n < trips_.size(); n++) {
+        size_t i = top_down ? trips_.size() - 1 - n : n;
+        Trip& trip = trips_[i];
+        trip.programmed_temp = std::lround(thresholds[i] * 1000.0);
+        trip.programmed_hyst = std::lround(std::max(hysteresis, 0.0) * 1000.0);
+
+        if (!writeValue(trip.temp_path, std::to_string(trip.programmed_temp))) {
+            std::cerr << "Failed to write " << trip.temp_path << std::endl;
+            ok = false;
+        }
+        if (trip.hyst_writable &&
+            !writeValue(trip.hyst_path, std::to_string(trip.programmed_hyst))) {
+            std::cerr << "Failed to write " << trip.hyst_path << std::endl;
+            ok = false;
+        }
+    }
+    programmed_ = true;
+    return ok && verify();
+}
+
+bool KernelOffload::verify() const {
+    for (const Trip& trip : trips_) {
+        std::string value;
+        if (!readValue(trip.temp_path, value) || std::atol(value.c_str()) != trip.programmed_temp) {
+            return false;
+        }
+        if (trip.hyst_writable &&
+            (!readValue(trip.hyst_path, value) || std::atol(value.c_str()) != trip.programmed_hyst)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KernelOffload::restore() {
+    if (!programmed_) {
+        return;
+    }
+    // Original trips are ascending; restore top-down or bottom-up like program()
+    long original_low = std::atol(trips_.front().original_temp.c_str());
+    bool top_down = original_low > trips_.front().programmed_temp;
+    for (size_t n = 0; n < trips_.size(); n++) {
+        const Trip& trip = trips_[top_down ? trips_.size() - 1 - n : n];
+        writeValue(trip.temp_path, trip.original_temp);
+        if (trip.hyst_writable) {
+            writeValue(trip.hyst_path, trip.original_hyst);
+        }
+    }
+    programmed_ = false;
+}
+
+double KernelOffload::zoneTemperature() const {
+    std::string value;
+    if (!readValue(zone_path_ + "/temp", value)) {
+        return std::nan("");
+    }
+    return std::atol(value.c_str()) / 1000.0;
+}
+
+int KernelOffload::coolingState() const {
+    std::string value;
+    if (!readValue(cdev_path_ + "/cur_state", value)) {
+        return -1;
+    }
+    return std::atoi(value.c_str());
+}
+
+KernelOffload::Stats KernelOffload::readStats() const {
+    // Present only with CONFIG_THERMAL_STATISTICS
+    Stats stats;
+    std::string value;
+    if (!readValue(cdev_path_ + "/stats/total_trans", value)) {
+        return stats;
+    }
+    stats.available = true;
+    stats.total_trans = std::strtoull(value.c_str(), nullptr, 10);
+
+    std::string contents;
+    SysfsIo::readFile(cdev_path_ + "/stats/time_in_state_ms", contents);
+    std::istringstream time_file(contents);
+    std::string state;
+    uint64_t ms;
+    while (time_file >> state >> ms) {
+        stats.time_in_state_ms.push_back(ms);
+    }
+    return stats;
+}
@@ -5,7 +5,16 @@
 
 #include "fan_controller.hpp"
 #include "config_parser.hpp"
+#include "journal_importer.hpp"
+#include "kernel_governors.hpp"
+#include "thermal_simulator.hpp"
+#include "sysfs_io.hpp"
+#include <algorithm>
+#include <initializer_list>
 #include <iostream>
+#include <cstdio>
+#include <string>
+#include <vector>
 #include <csignal>
 #include <cstdlib>
 #include <unistd.h>
@@ -19,11 +28,87 @@ static FanController* g_controller = nullptr;
  */
 void signalHandler(int signal) {
     if (g_controller) {
+        SysfsIo::recordStop();
         std::cerr << "Received signal " << signal << ", shutting down..." << std::endl;
         g_controller->stop();
     }
 }
 
+/**
+ * @brief Convert journald exports into a thermal trace and exit
+ * @param inputs Export files ("-" for stdin)
+ * @param output_path Trace destination ("-" for stdout)
+ * @return Process exit code
+ */
+int importJournal(const std::vector<std::string>& inputs, const std::string& output_path) {
+    std::FILE* output = stdout;
+    if (output_path != "-") {
+        output = std::fopen(output_path.c_str(), "w");
+        if (output == nullptr) {
+            std::cerr << "Failed to open trace output: " << output_path << std::endl;
+            return 1;
+        }
+    }
+
+    JournalImporter importer(output);
+    bool ok = true;
+    for (const std::string& input : inputs) {
+        ok = importer.importFile(input) && ok;
+    }
+    ok = importer.finish() && ok;
+    importer.printSummary(std::cerr);
+
+    if (output != stdout) {
+        std::fclose(output);
+    }
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Score the threshold ladder against the kernel governors on the simulated plant
+ * @param config Thresholds, hysteresis and interval to simulate
+ * @param trace_path Recorded trace to replay (empty for the synthetic workload)
+ * @param node Trace node to replay (empty for the first one)
+ * @param hours Length of the synthetic workload
+ * @param polling_ms Governor polling delay
+ * @return Process exit code
+ */
+int simulate(const FanControllerConfig& config, const std::string& trace_path, std::string node,
+             double hours, int polling_ms) {
+    ThermalSimulator simulator(config, ThermalSimulator::Plant());
+    if (trace_path.empty()) {
+        simulator.useSyntheticWorkload(hours);
+        std::cout << "Synthetic workload, " << hours << " h\n";
+    } else {
+        std::vector<ThermalTrace::Sample> samples;
+        std::string error;
+        if (!ThermalTrace::load(trace_path, node, samples, error)) {
+            std::cerr << "Failed to load trace: " << error << std::endl;
+            return 1;
+        }
+        simulator.useTrace(samples);
+        std::cout << "Trace " << trace_path << ", node " << node << ", " << samples.size()
+                  << " samples\n";
+    }
+
+    GovernorZone zone = GovernorZone::fromConfig(config, std::max(polling_ms, 1) / 1000.0);
+    LadderPolicy ladder(config);
+    StepWiseGovernor step_wise(zone);
+    BangBangGovernor bang_bang(zone);
+    PowerAllocatorGovernor power_allocator(zone);
+
+    std::vector<ThermalSimulator::Scorecard> cards;
+    if (!trace_path.empty()) {
+        cards.push_back(simulator.runRecorded());
+    }
+    for (FanPolicy* policy : std::initializer_list<FanPolicy*>{&ladder, &step_wise, &bang_bang,
+                                                               &power_allocator}) {
+        cards.push_back(simulator.run(*policy));
+    }
+    ThermalSimulator::printScorecards(std::cout, cards);
+    return 0;
+}
+
 /**
  * @brief Main entry point
  *
@@ -31,31 +116,92 @@ void signalHandler(int signal) {
  * initializes the controller, and runs the main control loop.
  */
 int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+    // Recording and replay wrap everything below, reading the configuration included
+    for (size_t i = 0; i + 1 < args.size(); i++) {
+        if (args[i] != "--record" && args[i] != "--replay") {
+            continue;
+        }
+        std::string log_path = args[i + 1];
+        bool replay = args[i] == "--replay";
+        args.erase(args.begin() + i, args.begin() + i + 2);
+
+        std::string error;
+        bool ok = replay ? SysfsIo::startReplay(log_path, args, error)
+                         : SysfsIo::startRecording(log_path, args, error);
+        if (!ok) {
+            std::cerr << "Failed to " << (replay ? "replay" : "record") << " I/O: " << error << std::endl;
+            return 1;
+        }
+        if (replay) {
+            SysfsIo::setReplayStopHandler([] {
+                if (g_controller) {
+                    g_controller->stop();
+                }
+            });
+        }
+        break;
+    }
+
     // Parse configuration with priority: config file > environment > defaults
     FanControllerConfig config;
 
     // Try configuration file first
     const char* config_path = "/etc/pi5-fan-controller/pi5-fan-controller.conf";
-    if (access(config_path, R_OK) == 0) {
+    if (SysfsIo::access(config_path, R_OK)) {
         config = ConfigParser::parseConfigFile(config_path);
     } else {
         // Fall back to environment variables or defaults
         config = ConfigParser::parseEnvironment();
     }
 
+    std::vector<std::string> journal_inputs;
+    std::string output_path = "-";
+    bool simulation = false;
+    std::string trace_path;
+    std::string trace_node;
+    double simulate_hours = 24.0;
+    int polling_ms = 1000;
+
     // Override with command line arguments if provided
-    for (int i = 1; i < argc; i++) {
-        std::string arg = argv[i];
-        if (arg == "--config" && i + 1 < argc) {
-            config = ConfigParser::parseConfigFile(argv[++i]);
+    for (size_t i = 0; i < args.size(); i++) {
+        const std::string& arg = args[i];
+        bool has_value = i + 1 < args.size();
+        if (arg == "--config" && has_value) {
+            config = ConfigParser::parseConfigFile(args[++i]);
+        } else if (arg == "--import-journal" && has_value) {
+            journal_inputs.push_back(args[++i]);
+        } else if (arg == "--output" && has_value) {
+            output_path = args[++i];
+        } else if (arg == "--simulate") {
+            simulation = true;
+        } else if (arg == "--trace" && has_value) {
+            trace_path = args[++i];
+        } else if (arg == "--node" && has_value) {
+            trace_node = args[++i];
+        } else if (arg == "--hours" && has_value) {
+            simulate_hours = std::atof(args[++i].c_str());
+        } else if (arg == "--polling-ms" && has_value) {
+            polling_ms = std::atoi(args[++i].c_str());
         } else if (arg == "--help" || arg == "-h") {
-            std::cout << "Usage: " << argv[0] << " [--config <path>] [--help]\n";
+            std::cout << "Usage: " << argv[0] << " [--config <path>] [--record <log> | --replay <log>] [--help]\n";
+            std::cout << "       " << argv[0] << " --import-journal <export|-> [...] [--output <trace>]\n";
+            std::cout << "       " << argv[0] << " --simulate [--trace <trace> [--node <name>]] [--hours <h>]"
+                         " [--polling-ms <ms>]\n";
             std::cout << "Configuration file: /etc/pi5-fan-controller/pi5-fan-controller.conf\n";
             std::cout << "Environment variables: FAN_PATH, HWMON0_NAME, HWMON1_NAME, etc.\n";
             return 0;
         }
     }
 
+    if (!journal_inputs.empty()) {
+        return importJournal(journal_inputs, output_path);
+    }
+    if (simulation) {
+        return simulate(config, trace_path, trace_node, simulate_hours, polling_ms);
+    }
+
     // Create controller
     FanController controller(config);
     g_controller = &controller;
@@ -67,12 +213,16 @@ int main(int argc, char* argv[]) {
     // Initialize controller
     if (!controller.initialize()) {
         std::cerr << "Failed to initialize fan controller" << std::endl;
+        SysfsIo::finish();
         return 1;
     }
 
-    // Run control loop
-    controller.run();
+    // Run control loop; a replay that already ended during initialization has nothing left to run
+    if (!SysfsIo::replayEnded()) {
+        controller.run();
+    }
 
+    SysfsIo::finish();
     return 0;
 }
 
@@ -0,0 +1,393 @@
+/**
+ * @file policy_expression.cpp
+ * @brief Compiler and evaluator for policy expressions
+ */
+
+#include "policy_expression.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"OFF", "LOW", "MEDIUM", "HIGH", "FULL"};
+const char* const FUNCTION_NAMES[] = {"min", "max", "clamp", "abs", "ladder"};
+
+} // namespace
+
+class PolicyExpression::Compiler {
+public:
+    Compiler(const std::string& source, const std::vector<std::string>& variables,
+             std::vector<Instruction>& code)
+        : src_(source), variables_(variables), code_(code)
+        , pos_(0), depth_(0), max_depth_(0), nesting_(0) {}
+
+    bool run(std::string& error) {
+        skipSpace();
+        if (pos_ >= src_.size()) {
+            error_ = "empty expression";
+        } else {
+            parseExpr();
+            skipSpace();
+            if (error_.empty() && pos_ < src_.size()) {
+                fail("unexpected '" + std::string(1, src_[pos_]) + "'");
+            }
+        }
+        if (error_.empty() && max_depth_ > MAX_STACK) {
+            error_ = "expression needs " + std::to_string(max_depth_) +
+                     " stack slots, limit is " + std::to_string(MAX_STACK);
+        }
+        if (error_.empty() && code_.size() > MAX_INSTRUCTIONS) {
+            error_ = "expression compiles to " + std::to_string(code_.size()) +
+                     " instructions, limit is " + std::to_string(MAX_INSTRUCTIONS);
+        }
+        error = error_;
+        return error_.empty();
+    }
+
+private:
+    static constexpr int MAX_NESTING = 64;
+
+    const std::string& src_;
+    const std::vector<std::string>& variables_;
+    std::vector<Instruction>& code_;
+    size_t pos_;
+    size_t depth_;
+    size_t max_depth_;
+    int nesting_;
+    std::string error_;
+
+    void fail(const std::string& message) {
+        if (error_.empty()) {
+            error_ = message + " at column " + std::to_string(pos_ + 1);
+        }
+    }
+
+    // Emit an instruction that pops `pops` values and pushes one
+    void emit(Op op, size_t pops, uint32_t index = 0, double value = 0.0) {
+        code_.push_back({op, index, value});
+        depth_ = depth_ + 1 - pops;
+        max_depth_ = std::max(max_depth_, depth_);
+    }
+
+    void skipSpace() {
+        while (pos_ < src_.size() && std::isspace(static_cast<unsigned char>(src_[pos_]))) {
+            pos_++;
+        }
+    }
+
+    bool accept(const char* token) {
+        skipSpace();
+        size_t len = std::char_traits<char>::length(token);
+        if (src_.compare(pos_, len, token) == 0) {
+            pos_ += len;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(const char* token) {
+        if (!accept(token)) {
+            fail(std::string("expected '") + token + "'");
+        }
+    }
+
+    void parseExpr() {
+        if (++nesting_ > MAX_NESTING) {
+            fail("expression nested too deeply");
+            return;
+        }
+        parseOr();
+        if (accept("?")) {
+            parseExpr();
+            expect(":");
+            parseExpr();
+            emit(Op::Select, 3);
+        }
+        nesting_--;
+    }
+
+    void parseOr() {
+        parseAnd();
+        while (error_.empty() && accept("||")) {
+            parseAnd();
+            emit(Op::Or, 2);
+        }
+    }
+
+    void parseAnd() {
+        parseCompare();
+        while (error_.empty() && accept("&&")) {
+            parseCompare();
+            emit(Op::And, 2);
+        }
+    }
+
+    void parseCompare() {
+        parseSum();
+        // Longest tokens first so "<=" is not read as "<"
+        static const struct { const char* token; Op op; } ops[] = {
+            {"<=", Op::Le}, {">=", Op::Ge}, {"==", Op::Eq}, {"!=", Op::Ne},
+            {"<", Op::Lt}, {">", Op::Gt},
+        };
+        for (const auto& entry : ops) {
+            if (accept(entry.token)) {
+                parseSum();
+                emit(entry.op, 2);
+                return;
+            }
+        }
+    }
+
+    void parseSum() {
+        parseProduct();
+        while (error_.empty()) {
+            if (accept("+")) {
+                parseProduct();
+                emit(Op::Add, 2);
+            } else if (accept("-")) {
+                parseProduct();
+                emit(Op::Sub, 2);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void parseProduct() {
+        parseUnary();
+        while (error_.empty()) {
+            if (accept("*")) {
+                parseUnary();
+                emit(Op::Mul, 2);
+            } else if (accept("/")) {
+                parseUnary();
+                emit(Op::Div, 2);
+            } else {
+                break;
+            }
+        }
+    }
+
+    void parseUnary() {
+        if (++nesting_ > MAX_NESTING) {
+            fail("expression nested too deeply");
+            return;
+        }
+        skipSpace();
+        if (accept("-")) {
+            parseUnary();
+            emit(Op::Neg, 1);
+        } else if (src_.compare(pos_, 2, "!=") != 0 && accept("!")) {
+            parseUnary();
+            emit(Op::Not, 1);
+        } else {
+            parsePrimary();
+        }
+        nesting_--;
+    }
+
+    void parsePrimary() {
+        skipSpace();
+        if (pos_ >= src_.size()) {
+            fail("unexpected end of expression");
+            return;
+        }
+
+        char c = src_[pos_];
+        if (std::isdigit(static_cast<unsigned char>(c)) || c == '.') {
+            const char* begin = src_.c_str() + pos_;
+            char* end = nullptr;
+            double value = std::strtod(begin, &end);
+            if (end == begin) {
+                fail("invalid number");
+                return;
+            }
+            pos_ += static_cast<size_t>(end - begin);
+            emit(Op::PushConst, 0, 0, value);
+            return;
+        }
+
+        if (accept("(")) {
+            parseExpr();
+            expect(")");
+            return;
+        }
+
+        if (!std::isalpha(static_cast<unsigned char>(c)) && c != '_') {
+            fail("unexpected '" + std::string(1, c) + "'");
+            return;
+        }
+
+        size_t start = pos_;
+        while (pos_ < src_.size() &&
+               (std::isalnum(static_cast<unsigned char>(src_[pos_])) || src_[pos_] == '_')) {
+            pos_++;
+        }
+        std::string name = src_.substr(start, pos_ - start);
+
+        if (accept("(")) {
+            parseCall(name);
+            return;
+        }
+
+        for (int level = 0; level < 5; level++) {
+            if (name == LEVEL_NAMES[level]) {
+                emit(Op::PushConst, 0, 0, level);
+                return;
+            }
+        }
+
+        auto it = std::find(variables_.begin(), variables_.end(), name);
+        if (it == variables_.end()) {
+            pos_ = start;
+            fail("unknown variable '" + name + "'");
+            return;
+        }
+        emit(Op::PushVar, 0, static_cast<uint32_t>(it - variables_.begin()));
+    }
+
+    void parseCall(const std::string& name) {
+        size_t argc = 0;
+        if (!accept(")")) {
+            do {
+                parseExpr();
+                argc++;
+            } while (error_.empty() && accept(","));
+            expect(")");
+        }
+        if (!error_.empty()) {
+            return;
+        }
+
+        if (name == "min" || name == "max") {
+            if (argc < 2) {
+                fail(name + "() needs at least two arguments");
+                return;
+            }
+            for (size_t i = 1; i < argc; i++) {
+                emit(name == "min" ? Op::Min : Op::Max, 2);
+            }
+        } else if (name == "clamp") {
+            if (argc != 3) {
+                fail("clamp() takes three arguments");
+                return;
+            }
+            emit(Op::Clamp, 3);
+        } else if (name == "abs") {
+            if (argc != 1) {
+                fail("abs() takes one argument");
+                return;
+            }
+            emit(Op::Abs, 1);
+        } else if (name == "ladder") {
+            if (argc != 1) {
+                fail("ladder() takes one argument");
+                return;
+            }
+            emit(Op::Ladder, 1);
+        } else {
+            fail("unknown function '" + name + "'");
+        }
+    }
+};
+
+bool PolicyExpression::isReservedName(const std::string& name) {
+    return std::find(std::begin(LEVEL_NAMES), std::end(LEVEL_NAMES), name) != std::end(LEVEL_NAMES) ||
+           std::find(std::begin(FUNCTION_NAMES), std::end(FUNCTION_NAMES), name) != std::end(FUNCTION_NAMES);
+}
+
+bool PolicyExpression::compile(const std::string& source, const std::vector<std::string>& variables,
+                               const PolicyLadder& ladder, std::string& error) {
+    std::vector<Instruction> code;
+    Compiler compiler(source, variables, code);
+    if (!compiler.run(error)) {
+        return false;
+    }
+
+    code_ = std::move(code);
+    code_.shrink_to_fit();
+    source_ = source;
+    ladder_ = ladder;
+    return true;
+}
+
+double PolicyExpression::ladderLevel(double temperature, double current_level) const {
+    if (std::isnan(temperature)) {
+        return std::nan("");
+    }
+
+    int target = 0;
+    while (target < 4 && temperature >= ladder_.thresholds[target]) {
+        target++;
+    }
+
+    // Same rule as the controller: step down only once below threshold minus hysteresis
+    if (ladder_.hysteresis > 0.0 && target < current_level &&
+        temperature > ladder_.thresholds[target] - ladder_.hysteresis) {
+        return current_level;
+    }
+    return target;
+}
+
+double PolicyExpression::evaluate(const double* variables, double current_level) const {
+    std::array<double, MAX_STACK> stack;
+    size_t sp = 0;
+
+    for (const Instruction& ins : code_) {
+        switch (ins.op) {
+            case Op::PushConst:
+                stack[sp++] = ins.value;
+                break;
+            case Op::PushVar:
+                stack[sp++] = variables[ins.index];
+                break;
+            case Op::Neg:
+                stack[sp - 1] = -stack[sp - 1];
+                break;
+            case Op::Not:
+                stack[sp - 1] = stack[sp - 1] == 0.0 ? 1.0 : 0.0;
+                break;
+            case Op::Abs:
+                stack[sp - 1] = std::fabs(stack[sp - 1]);
+                break;
+            case Op::Ladder:
+                stack[sp - 1] = ladderLevel(stack[sp - 1], current_level);
+                break;
+            case Op::Clamp:
+                sp -= 2;
+                stack[sp - 1] = std::fmin(std::fmax(stack[sp - 1], stack[sp]), stack[sp + 1]);
+                break;
+            case Op::Select:
+                sp -= 2;
+                stack[sp - 1] = stack[sp - 1] != 0.0 ? stack[sp] : stack[sp + 1];
+                break;
+            default: {
+                double rhs = stack[--sp];
+                double& lhs = stack[sp - 1];
+                switch (ins.op) {
+                    case Op::Add: lhs = lhs + rhs; break;
+                    case Op::Sub: lhs = lhs - rhs; break;
+                    case Op::Mul: lhs = lhs * rhs; break;
+                    case Op::Div: lhs = lhs / rhs; break;
+                    case Op::Lt: lhs = lhs < rhs; break;
+                    case Op::Le: lhs = lhs <= rhs; break;
+                    case Op::Gt: lhs = lhs > rhs; break;
+                    case Op::Ge: lhs = lhs >= rhs; break;
+                    case Op::Eq: lhs = lhs == rhs; break;
+                    case Op::Ne: lhs = lhs != rhs; break;
+                    case Op::And: lhs = (lhs != 0.0) && (rhs != 0.0); break;
+                    case Op::Or: lhs = (lhs != 0.0) || (rhs != 0.0); break;
+                    case Op::Min: lhs = std::fmin(lhs, rhs); break;
+                    case Op::Max: lhs = std::fmax(lhs, rhs); break;
+                    default: break;
+                }
+                break;
+            }
+        }
+    }
+
+    return sp == 1 ? stack[0] : std::nan("");
+}
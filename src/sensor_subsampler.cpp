@@ -0,0 +1,195 @@
+/**
+ * @file sensor_subsampler.cpp
+ * @brief Implementation of correlation-aware sensor subsampling
+ */
+
+#include "sensor_subsampler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+SensorSubsampler::SensorSubsampler(const std::vector<std::string>& names, const Settings& settings)
+    : settings_(settings)
+    , channels_(names.size())
+    , pairs_(names.size() * names.size())
+{
+    settings_.factor = std::max(settings_.factor, 2);
+    for (size_t i = 0; i < names.size(); i++) {
+        channels_[i].name = names[i];
+    }
+}
+
+void SensorSubsampler::beginCycle() {
+    for (Channel& channel : channels_) {
+        if (channel.predictor < 0) {
+            channel.read_this_cycle = true;
+        } else {
+            channel.phase = (channel.phase + 1) % settings_.factor;
+            channel.read_this_cycle = (channel.phase == 0);
+        }
+    }
+}
+
+double SensorSubsampler::predict(size_t x, size_t y, double x_value) const {
+    const PairStats& p = pair(x, y);
+    if (p.var_x < 1e-9) {
+        return p.mean_y;
+    }
+    return p.mean_y + p.cov / p.var_x * (x_value - p.mean_x);
+}
+
+double SensorSubsampler::correlation(size_t x, size_t y) const {
+    const PairStats& p = pair(x, y);
+    double denom = std::sqrt(p.var_x * p.var_y);
+    return denom > 1e-12 ? p.cov / denom : 0.0;
+}
+
+void SensorSubsampler::updatePair(size_t x, size_t y, double x_value, double y_value) {
+    PairStats& p = pair(x, y);
+
+    // Score the prediction before the sample joins the statistics
+    if (p.samples >= 2.0) {
+        double residual = y_value - predict(x, y, x_value);
+        double alpha = std::max(settings_.decay, 1.0 / (p.samples - 1.0));
+        p.residual_ms += alpha * (residual * residual - p.residual_ms);
+    }
+
+    // Exact running averages at first, exponentially weighted once warmed up
+    double alpha = std::max(settings_.decay, 1.0 / (p.samples + 1.0));
+    double dx = x_value - p.mean_x;
+    double dy = y_value - p.mean_y;
+    p.mean_x += alpha * dx;
+    p.mean_y += alpha * dy;
+    p.var_x = (1.0 - alpha) * (p.var_x + alpha * dx * dx);
+    p.var_y = (1.0 - alpha) * (p.var_y + alpha * dy * dy);
+    p.cov = (1.0 - alpha) * (p.cov + alpha * dx * dy);
+    p.samples += 1.0;
+}
+
+void SensorSubsampler::considerReducing(size_t channel) {
+    // A channel other channels are estimated from must stay at full rate
+    for (const Channel& other : channels_) {
+        if (other.predictor == static_cast<int>(channel)) {
+            return;
+        }
+    }
+
+    int best = -1;
+    double best_rms = settings_.max_residual / 2.0;
+    for (size_t x = 0; x < channels_.size(); x++) {
+        if (x == channel || channels_[x].predictor >= 0) {
+            continue;
+        }
+        const PairStats& p = pair(x, channel);
+        double rms = std::sqrt(p.residual_ms);
+        if (p.samples >= settings_.warmup_samples &&
+            std::fabs(correlation(x, channel)) >= settings_.min_correlation && rms <= best_rms) {
+            best = static_cast<int>(x);
+            best_rms = rms;
+        }
+    }
+    if (best < 0) {
+        return;
+    }
+
+    Channel& c = channels_[channel];
+    c.predictor = best;
+    c.phase = 0;
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3) << "Subsampling " << c.name << " 1/"
+        << settings_.factor << ", estimated from " << channels_[best].name
+        << " (r=" << correlation(best, channel) << ", rms " << best_rms << "°C)";
+    events_.push_back(oss.str());
+}
+
+void SensorSubsampler::complete(double* values) {
+    size_t n = channels_.size();
+
+    for (size_t i = 0; i < n; i++) {
+        Channel& c = channels_[i];
+        if (c.read_this_cycle) {
+            c.reads++;
+        }
+        if (c.predictor < 0) {
+            continue;
+        }
+
+        double x_value = values[c.predictor];
+        if (std::isnan(x_value)) {
+            c.predictor = -1;
+            if (!c.read_this_cycle) {
+                events_.push_back(c.name + " back to full rate: predictor unavailable");
+            }
+            continue;
+        }
+
+        double estimate = predict(c.predictor, i, x_value);
+        if (!c.read_this_cycle) {
+            values[i] = estimate;
+            c.skipped++;
+            continue;
+        }
+
+        if (!std::isnan(values[i])) {
+            double error = std::fabs(values[i] - estimate);
+            c.checks++;
+            c.abs_error_sum += error;
+            c.max_abs_error = std::max(c.max_abs_error, error);
+            if (error > settings_.max_residual) {
+                std::ostringstream oss;
+                oss << std::fixed << std::setprecision(3) << c.name
+                    << " back to full rate: residual " << error << "°C";
+                events_.push_back(oss.str());
+                c.predictor = -1;
+            }
+        }
+    }
+
+    // Statistics only learn from genuine reads of both channels
+    for (size_t x = 0; x < n; x++) {
+        if (!channels_[x].read_this_cycle || std::isnan(values[x])) {
+            continue;
+        }
+        for (size_t y = 0; y < n; y++) {
+            if (y != x && channels_[y].read_this_cycle && !std::isnan(values[y])) {
+                updatePair(x, y, values[x], values[y]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        if (channels_[i].predictor < 0) {
+            considerReducing(i);
+        }
+    }
+}
+
+std::vector<std::string> SensorSubsampler::takeEvents() {
+    std::vector<std::string> events;
+    events.swap(events_);
+    return events;
+}
+
+std::string SensorSubsampler::report() const {
+    uint64_t reads = 0, skipped = 0;
+    for (const Channel& c : channels_) {
+        reads += c.reads;
+        skipped += c.skipped;
+    }
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1) << "saved " << skipped << " of " << (reads + skipped)
+        << " sensor reads (" << (reads + skipped ? 100.0 * skipped / (reads + skipped) : 0.0) << "%)";
+    for (const Channel& c : channels_) {
+        if (c.checks == 0 && c.skipped == 0) {
+            continue;
+        }
+        oss << std::setprecision(3) << "; " << c.name << ": " << c.skipped << " estimated, check error mean "
+            << (c.checks ? c.abs_error_sum / c.checks : 0.0) << "°C max " << c.max_abs_error
+            << "°C over " << c.checks << " check(s)"
+            << (c.predictor >= 0 ? ", subsampled" : ", full rate");
+    }
+    return oss.str();
+}
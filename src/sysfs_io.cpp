@@ -0,0 +1,860 @@
+/**
+ * @file sysfs_io.cpp
+ * @brief Implementation of the recordable I/O layer
+ */
+
+#include "sysfs_io.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+extern char** environ;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char LOG_MAGIC[4] = {'P', '5', 'I', 'O'};
+const uint8_t LOG_VERSION = 2;
+
+const uint8_t FLAG_ERRNO = 0x20;
+const uint8_t FLAG_DATA = 0x40;
+const uint8_t OP_MASK = 0x1f;
+
+// Flush the record buffer at least this often, and on every sleep
+const size_t FLUSH_BYTES = 64 * 1024;
+
+enum class Op : uint8_t {
+    PATH = 1,
+    EXISTS,
+    ACCESS,
+    FILE_MODE,
+    MTIME,
+    READ_FILE,
+    WRITE_FILE,
+    REPLACE_FILE,
+    LIST_DIR,
+    CANONICAL,
+    OPEN,
+    WRITE,
+    PREAD,
+    PWRITE,
+    FSYNC,
+    CLOSE,
+    CLOCK,
+    SLEEP,
+    ENVIRONMENT,
+    RANDOM_SEED,
+    STOP,
+    ONLINE_CPUS
+};
+
+const char* opName(Op op) {
+    static const char* const names[] = {"?", "path", "exists", "access", "stat", "mtime", "read",
+                                        "write-file", "replace", "list", "canonical", "open", "write",
+                                        "pread", "pwrite", "fsync", "close", "clock", "sleep",
+                                        "environment", "seed", "stop", "cpus"};
+    size_t index = static_cast<size_t>(op);
+    return index < std::size(names) ? names[index] : "?";
+}
+
+uint64_t nowMicros() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000u + static_cast<uint64_t>(ts.tv_nsec) / 1000u;
+}
+
+void putVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void putSigned(std::string& out, int64_t value) {
+    putVarint(out, (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+}
+
+std::string joinNames(const std::vector<std::string>& names) {
+    std::string joined;
+    for (const std::string& name : names) {
+        joined += name;
+        joined.push_back('\0');
+    }
+    return joined;
+}
+
+std::vector<std::string> splitNames(const std::string& joined) {
+    std::vector<std::string> names;
+    size_t start = 0;
+    for (size_t end; (end = joined.find('\0', start)) != std::string::npos; start = end + 1) {
+        names.push_back(joined.substr(start, end - start));
+    }
+    return names;
+}
+
+struct Record {
+    Op op;
+    uint64_t time_us;
+    std::string path;
+    int64_t result;
+    int error;
+    std::string data;
+};
+
+class Session {
+public:
+    enum class Mode { LIVE, RECORD, REPLAY };
+
+    Mode mode = Mode::LIVE;
+    std::function<void()> stop_handler;
+
+    bool startRecording(const std::string& log_path, const std::vector<std::string>& arguments,
+                        std::string& error);
+    bool startReplay(const std::string& log_path, std::vector<std::string>& arguments, std::string& error);
+    void finish();
+
+    // Record mode: append one operation; time_us = 0 stamps it now
+    void record(Op op, const std::string& path, int64_t result, int error,
+                const std::string* data = nullptr, uint64_t time_us = 0);
+    // Record mode: associate a descriptor with the path it was opened from
+    void trackFd(int fd, const std::string& path) { fd_paths_[fd] = path; }
+    void untrackFd(int fd) { fd_paths_.erase(fd); }
+    const std::string& fdPath(int fd) {
+        auto it = fd_paths_.find(fd);
+        return it != fd_paths_.end() ? it->second : empty_;
+    }
+
+    // Replay mode: the next record, which must be op on path; nullptr once replay has ended
+    const Record* next(Op op, const std::string& path);
+    void checkWritten(const Record& record, const void* buf, size_t count);
+    double virtualNow() const { return (start_us_ + clock_us_) / 1e6; }
+    bool ended() const { return ended_; }
+
+    void flush();
+
+private:
+    std::FILE* log_ = nullptr;
+    std::string pending_;
+    uint64_t start_us_ = 0;
+    uint64_t last_us_ = 0;
+    std::unordered_map<std::string, uint64_t> path_ids_;
+    std::unordered_map<uint64_t, std::string> last_data_;
+    std::unordered_map<int, std::string> fd_paths_;
+    std::string empty_;
+
+    // Replay
+    std::string buffer_;
+    size_t offset_ = 0;
+    std::vector<std::string> paths_;
+    Record current_;
+    uint64_t records_ = 0;
+    uint64_t clock_us_ = 0;
+    bool ended_ = false;
+
+    bool getVarint(uint64_t& value);
+    bool getSigned(int64_t& value);
+    bool getBytes(size_t count, std::string& bytes);
+    bool decode(Record& record);
+    void end(const std::string& reason);
+    void encodeData(uint64_t id, const std::string& data);
+};
+
+Session g_session;
+volatile std::sig_atomic_t g_stop_requested = 0;
+
+bool Session::startRecording(const std::string& log_path, const std::vector<std::string>& arguments,
+                             std::string& error) {
+    log_ = std::fopen(log_path.c_str(), "wb");
+    if (log_ == nullptr) {
+        error = "cannot create " + log_path + ": " + std::strerror(errno);
+        return false;
+    }
+
+    start_us_ = nowMicros();
+    last_us_ = 0;
+    pending_.assign(LOG_MAGIC, sizeof(LOG_MAGIC));
+    pending_.push_back(static_cast<char>(LOG_VERSION));
+    for (int shift = 0; shift < 64; shift += 8) {
+        pending_.push_back(static_cast<char>((start_us_ >> shift) & 0xff));
+    }
+    putVarint(pending_, arguments.size());
+    for (const std::string& argument : arguments) {
+        putVarint(pending_, argument.size());
+        pending_ += argument;
+    }
+    mode = Mode::RECORD;
+    flush();
+    return true;
+}
+
+void Session::record(Op op, const std::string& path, int64_t result, int error, const std::string* data,
+                     uint64_t time_us) {
+    if (g_stop_requested) {
+        // Emitted here rather than in the signal handler, before the operation it interrupted
+        g_stop_requested = 0;
+        pending_.push_back(static_cast<char>(Op::STOP));
+    }
+
+    uint64_t id = 0;
+    if (!path.empty()) {
+        auto it = path_ids_.find(path);
+        if (it == path_ids_.end()) {
+            id = path_ids_.size() + 1;
+            path_ids_.emplace(path, id);
+            pending_.push_back(static_cast<char>(Op::PATH));
+            putVarint(pending_, path.size());
+            pending_ += path;
+        } else {
+            id = it->second;
+        }
+    }
+
+    uint64_t elapsed = (time_us ? time_us : nowMicros()) - start_us_;
+    uint8_t head = static_cast<uint8_t>(op);
+    if (error != 0) {
+        head |= FLAG_ERRNO;
+    }
+    if (data != nullptr) {
+        head |= FLAG_DATA;
+    }
+    pending_.push_back(static_cast<char>(head));
+    putVarint(pending_, elapsed >= last_us_ ? elapsed - last_us_ : 0);
+    last_us_ = std::max(last_us_, elapsed);
+    putVarint(pending_, id);
+    putSigned(pending_, result);
+    if (error != 0) {
+        pending_.push_back(static_cast<char>(std::min(error, 255)));
+    }
+    if (data != nullptr) {
+        encodeData(id, *data);
+    }
+
+    if (pending_.size() >= FLUSH_BYTES) {
+        flush();
+    }
+}
+
+void Session::encodeData(uint64_t id, const std::string& data) {
+    // Sysfs values mostly change in a few digits: keep only what differs from last time
+    std::string& last = last_data_[id];
+    size_t limit = std::min(last.size(), data.size());
+    size_t prefix = 0;
+    while (prefix < limit && last[prefix] == data[prefix]) {
+        prefix++;
+    }
+    size_t suffix = 0;
+    while (suffix < limit - prefix && last[last.size() - 1 - suffix] == data[data.size() - 1 - suffix]) {
+        suffix++;
+    }
+    putVarint(pending_, prefix);
+    putVarint(pending_, suffix);
+    putVarint(pending_, data.size() - prefix - suffix);
+    pending_.append(data, prefix, data.size() - prefix - suffix);
+    last = data;
+}
+
+void Session::flush() {
+    if (log_ != nullptr && !pending_.empty()) {
+        std::fwrite(pending_.data(), 1, pending_.size(), log_);
+        std::fflush(log_);
+        pending_.clear();
+    }
+}
+
+bool Session::startReplay(const std::string& log_path, std::vector<std::string>& arguments,
+                          std::string& error) {
+    std::ifstream file(log_path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot open " + log_path;
+        return false;
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+    std::string magic;
+    uint64_t count = 0;
+    bool ok = getBytes(sizeof(LOG_MAGIC), magic) && std::memcmp(magic.data(), LOG_MAGIC, 4) == 0 &&
+              offset_ < buffer_.size() && static_cast<uint8_t>(buffer_[offset_++]) == LOG_VERSION &&
+              offset_ + 8 <= buffer_.size();
+    if (ok) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            start_us_ |= static_cast<uint64_t>(static_cast<uint8_t>(buffer_[offset_++])) << shift;
+        }
+        ok = getVarint(count);
+    }
+    arguments.clear();
+    for (uint64_t i = 0; ok && i < count; i++) {
+        uint64_t length = 0;
+        std::string argument;
+        ok = getVarint(length) && getBytes(length, argument);
+        arguments.push_back(argument);
+    }
+    if (!ok) {
+        error = log_path + " is not an I/O log";
+        return false;
+    }
+    mode = Mode::REPLAY;
+    return true;
+}
+
+bool Session::getVarint(uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64 && offset_ < buffer_.size(); shift += 7) {
+        uint8_t byte = static_cast<uint8_t>(buffer_[offset_++]);
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Session::getSigned(int64_t& value) {
+    uint64_t raw = 0;
+    if (!getVarint(raw)) {
+        return false;
+    }
+    value = static_cast<int64_t>(raw >> 1) ^ -static_cast<int64_t>(raw & 1);
+    return true;
+}
+
+bool Session::getBytes(size_t count, std::string& bytes) {
+    if (count > buffer_.size() - offset_) {
+        return false;
+    }
+    bytes.assign(buffer_, offset_, count);
+    offset_ += count;
+    return true;
+}
+
+bool Session::decode(Record& record) {
+    while (offset_ < buffer_.size()) {
+        uint8_t head = static_cast<uint8_t>(buffer_[offset_++]);
+        Op op = static_cast<Op>(head & OP_MASK);
+        if (op == Op::PATH) {
+            uint64_t length = 0;
+            std::string path;
+            if (!getVarint(length) || !getBytes(length, path)) {
+                return false;
+            }
+            paths_.push_back(path);
+            continue;
+        }
+        if (op == Op::STOP) {
+            if (stop_handler) {
+                stop_handler();
+            }
+            continue;
+        }
+
+        uint64_t delta = 0, id = 0;
+        if (!getVarint(delta) || !getVarint(id) || !getSigned(record.result) || id > paths_.size()) {
+            return false;
+        }
+        record.op = op;
+        record.time_us = clock_us_ + delta;
+        record.path = id ? paths_[id - 1] : std::string();
+        record.error = 0;
+        if (head & FLAG_ERRNO) {
+            if (offset_ >= buffer_.size()) {
+                return false;
+            }
+            record.error = static_cast<uint8_t>(buffer_[offset_++]);
+        }
+        record.data.clear();
+        if (head & FLAG_DATA) {
+            uint64_t prefix = 0, suffix = 0, length = 0;
+            std::string middle;
+            std::string& last = last_data_[id];
+            if (!getVarint(prefix) || !getVarint(suffix) || !getVarint(length) ||
+                prefix + suffix > last.size() || !getBytes(length, middle)) {
+                return false;
+            }
+            record.data = last.substr(0, prefix) + middle + last.substr(last.size() - suffix);
+            last = record.data;
+        }
+        return true;
+    }
+    return false;
+}
+
+const Record* Session::next(Op op, const std::string& path) {
+    if (ended_) {
+        errno = EIO;
+        return nullptr;
+    }
+    if (!decode(current_)) {
+        end(offset_ >= buffer_.size() ? "log exhausted" : "log truncated");
+        errno = EIO;
+        return nullptr;
+    }
+    if (current_.op != op || current_.path != path) {
+        end(std::string("diverged: controller did ") + opName(op) + " " + path + ", log has " +
+            opName(current_.op) + " " + current_.path);
+        errno = EIO;
+        return nullptr;
+    }
+    records_++;
+    clock_us_ = current_.time_us;
+    if (offset_ >= buffer_.size()) {
+        // Stop at the last recorded operation rather than failing the next cycle's
+        end("log exhausted");
+    }
+    errno = current_.error;
+    return &current_;
+}
+
+void Session::checkWritten(const Record& record, const void* buf, size_t count) {
+    std::string written(static_cast<const char*>(buf), count);
+    if (written != record.data) {
+        std::cerr << "I/O replay: wrote '" << written << "' to " << record.path << ", recorded '"
+                  << record.data << "'" << std::endl;
+    }
+}
+
+void Session::end(const std::string& reason) {
+    ended_ = true;
+    std::cerr << "I/O replay ended after " << records_ << " operations, "
+              << (clock_us_ / 1e6) << " s: " << reason << std::endl;
+    if (stop_handler) {
+        stop_handler();
+    }
+}
+
+void Session::finish() {
+    if (mode == Mode::RECORD) {
+        if (g_stop_requested) {
+            g_stop_requested = 0;
+            pending_.push_back(static_cast<char>(Op::STOP));
+        }
+        flush();
+        std::fclose(log_);
+        log_ = nullptr;
+        mode = Mode::LIVE;
+    } else if (mode == Mode::REPLAY && !ended_) {
+        std::cerr << "I/O replay stopped after " << records_ << " operations, "
+                  << (clock_us_ / 1e6) << " s" << std::endl;
+    }
+}
+
+bool replaying() {
+    return g_session.mode == Session::Mode::REPLAY;
+}
+
+bool recording() {
+    return g_session.mode == Session::Mode::RECORD;
+}
+
+} // namespace
+
+bool SysfsIo::startRecording(const std::string& log_path, const std::vector<std::string>& arguments,
+                             std::string& error) {
+    return g_session.startRecording(log_path, arguments, error);
+}
+
+bool SysfsIo::startReplay(const std::string& log_path, std::vector<std::string>& arguments,
+                          std::string& error) {
+    return g_session.startReplay(log_path, arguments, error);
+}
+
+void SysfsIo::setReplayStopHandler(std::function<void()> handler) {
+    g_session.stop_handler = std::move(handler);
+}
+
+void SysfsIo::recordStop() {
+    g_stop_requested = 1;
+}
+
+bool SysfsIo::replayEnded() {
+    return replaying() && g_session.ended();
+}
+
+void SysfsIo::finish() {
+    g_session.finish();
+}
+
+bool SysfsIo::exists(const std::string& path) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::EXISTS, path);
+        return r != nullptr && r->result != 0;
+    }
+    std::error_code ec;
+    bool result = fs::exists(path, ec);
+    if (recording()) {
+        g_session.record(Op::EXISTS, path, result ? 1 : 0, 0);
+    }
+    return result;
+}
+
+bool SysfsIo::access(const std::string& path, int mode) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::ACCESS, path);
+        return r != nullptr && r->result == 0;
+    }
+    int result = ::access(path.c_str(), mode);
+    int error = result != 0 ? errno : 0;
+    if (recording()) {
+        g_session.record(Op::ACCESS, path, result, error);
+    }
+    errno = error;
+    return result == 0;
+}
+
+int SysfsIo::fileMode(const std::string& path) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::FILE_MODE, path);
+        return r != nullptr ? static_cast<int>(r->result) : -1;
+    }
+    struct stat st;
+    int result = stat(path.c_str(), &st) == 0 ? static_cast<int>(st.st_mode) : -1;
+    int error = result < 0 ? errno : 0;
+    if (recording()) {
+        g_session.record(Op::FILE_MODE, path, result, error);
+    }
+    errno = error;
+    return result;
+}
+
+int64_t SysfsIo::modificationTime(const std::string& path) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::MTIME, path);
+        return r != nullptr ? r->result : -1;
+    }
+    struct stat st;
+    int64_t result = -1;
+    if (stat(path.c_str(), &st) == 0) {
+        result = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    }
+    int error = result < 0 ? errno : 0;
+    if (recording()) {
+        g_session.record(Op::MTIME, path, result, error);
+    }
+    errno = error;
+    return result;
+}
+
+bool SysfsIo::readFile(const std::string& path, std::string& contents, size_t max_bytes) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::READ_FILE, path);
+        if (r == nullptr || r->result < 0) {
+            return false;
+        }
+        contents = r->data;
+        return true;
+    }
+
+    contents.clear();
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    ssize_t n = fd < 0 ? -1 : 0;
+    char buf[4096];
+    size_t want = sizeof(buf);
+    while (fd >= 0 && (max_bytes == 0 || contents.size() < max_bytes)) {
+        if (max_bytes != 0) {
+            want = std::min(sizeof(buf), max_bytes - contents.size());
+        }
+        if ((n = ::read(fd, buf, want)) <= 0) {
+            break;
+        }
+        contents.append(buf, static_cast<size_t>(n));
+    }
+    int error = n < 0 ? errno : 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (recording()) {
+        g_session.record(Op::READ_FILE, path, n < 0 ? -1 : static_cast<int64_t>(contents.size()), error,
+                         n < 0 ? nullptr : &contents);
+    }
+    errno = error;
+    return n >= 0;
+}
+
+bool SysfsIo::writeFile(const std::string& path, const std::string& value) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::WRITE_FILE, path);
+        if (r != nullptr) {
+            g_session.checkWritten(*r, value.data(), value.size());
+        }
+        return r != nullptr && r->result == static_cast<int64_t>(value.size());
+    }
+
+    int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    ssize_t written = fd < 0 ? -1 : ::write(fd, value.data(), value.size());
+    int error = written < 0 ? errno : 0;
+    if (fd >= 0) {
+        ::close(fd);
+    }
+    if (recording()) {
+        g_session.record(Op::WRITE_FILE, path, written, error, &value);
+    }
+    errno = error;
+    return written == static_cast<ssize_t>(value.size());
+}
+
+bool SysfsIo::replaceFile(const std::string& path, const std::string& contents) {
+    if (replaying()) {
+        // Never overwrite local state with the replayed node's
+        const Record* r = g_session.next(Op::REPLACE_FILE, path);
+        return r != nullptr && r->result == 0;
+    }
+
+    std::string tmp_path = path + ".tmp";
+    std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    bool ok = file != nullptr && std::fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    if (file != nullptr) {
+        ok = (std::fclose(file) == 0) && ok;
+    }
+    ok = ok && std::rename(tmp_path.c_str(), path.c_str()) == 0;
+    int error = ok ? 0 : errno;
+    if (!ok) {
+        std::remove(tmp_path.c_str());
+    }
+    if (recording()) {
+        g_session.record(Op::REPLACE_FILE, path, ok ? 0 : -1, error);
+    }
+    errno = error;
+    return ok;
+}
+
+bool SysfsIo::listDirectory(const std::string& path, std::vector<std::string>& names) {
+    names.clear();
+    if (replaying()) {
+        const Record* r = g_session.next(Op::LIST_DIR, path);
+        if (r == nullptr || r->result < 0) {
+            return false;
+        }
+        names = splitNames(r->data);
+        return true;
+    }
+
+    std::error_code ec;
+    for (fs::directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+        names.push_back(it->path().filename().string());
+    }
+    if (recording()) {
+        std::string joined = joinNames(names);
+        g_session.record(Op::LIST_DIR, path, ec ? -1 : static_cast<int64_t>(names.size()), ec.value(),
+                         ec ? nullptr : &joined);
+    }
+    if (ec) {
+        names.clear();
+    }
+    return !ec;
+}
+
+std::string SysfsIo::canonical(const std::string& path) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::CANONICAL, path);
+        return r != nullptr && r->result == 0 ? r->data : std::string();
+    }
+
+    std::error_code ec;
+    std::string result = fs::canonical(path, ec).string();
+    if (ec) {
+        result.clear();
+    }
+    if (recording()) {
+        g_session.record(Op::CANONICAL, path, ec ? -1 : 0, ec.value(), ec ? nullptr : &result);
+    }
+    return result;
+}
+
+int SysfsIo::open(const std::string& path, int flags) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::OPEN, path);
+        int fd = r != nullptr ? static_cast<int>(r->result) : -1;
+        if (fd >= 0) {
+            g_session.trackFd(fd, path);
+        }
+        return fd;
+    }
+
+    int fd = ::open(path.c_str(), flags);
+    int error = fd < 0 ? errno : 0;
+    if (recording()) {
+        g_session.record(Op::OPEN, path, fd, error);
+        if (fd >= 0) {
+            g_session.trackFd(fd, path);
+        }
+    }
+    errno = error;
+    return fd;
+}
+
+ssize_t SysfsIo::write(int fd, const void* buf, size_t count) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::WRITE, g_session.fdPath(fd));
+        if (r != nullptr) {
+            g_session.checkWritten(*r, buf, count);
+        }
+        return r != nullptr ? static_cast<ssize_t>(r->result) : -1;
+    }
+
+    ssize_t result = ::write(fd, buf, count);
+    int error = result < 0 ? errno : 0;
+    if (recording()) {
+        std::string data(static_cast<const char*>(buf), count);
+        g_session.record(Op::WRITE, g_session.fdPath(fd), result, error, &data);
+    }
+    errno = error;
+    return result;
+}
+
+ssize_t SysfsIo::pread(int fd, void* buf, size_t count, off_t offset) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::PREAD, g_session.fdPath(fd));
+        if (r == nullptr) {
+            return -1;
+        }
+        std::memcpy(buf, r->data.data(), std::min(count, r->data.size()));
+        return static_cast<ssize_t>(r->result);
+    }
+
+    ssize_t result = ::pread(fd, buf, count, offset);
+    int error = result < 0 ? errno : 0;
+    if (recording()) {
+        std::string data(static_cast<const char*>(buf), result > 0 ? static_cast<size_t>(result) : 0);
+        g_session.record(Op::PREAD, g_session.fdPath(fd), result, error, &data);
+    }
+    errno = error;
+    return result;
+}
+
+ssize_t SysfsIo::pwrite(int fd, const void* buf, size_t count, off_t offset) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::PWRITE, g_session.fdPath(fd));
+        if (r != nullptr) {
+            g_session.checkWritten(*r, buf, count);
+        }
+        return r != nullptr ? static_cast<ssize_t>(r->result) : -1;
+    }
+
+    ssize_t result = ::pwrite(fd, buf, count, offset);
+    int error = result < 0 ? errno : 0;
+    if (recording()) {
+        std::string data(static_cast<const char*>(buf), count);
+        g_session.record(Op::PWRITE, g_session.fdPath(fd), result, error, &data);
+    }
+    errno = error;
+    return result;
+}
+
+int SysfsIo::fsync(int fd) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::FSYNC, g_session.fdPath(fd));
+        return r != nullptr ? static_cast<int>(r->result) : -1;
+    }
+
+    int result = ::fsync(fd);
+    int error = result != 0 ? errno : 0;
+    if (recording()) {
+        g_session.record(Op::FSYNC, g_session.fdPath(fd), result, error);
+    }
+    errno = error;
+    return result;
+}
+
+int SysfsIo::close(int fd) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::CLOSE, g_session.fdPath(fd));
+        g_session.untrackFd(fd);
+        return r != nullptr ? static_cast<int>(r->result) : -1;
+    }
+
+    int result = ::close(fd);
+    int error = result != 0 ? errno : 0;
+    if (recording()) {
+        g_session.record(Op::CLOSE, g_session.fdPath(fd), result, error);
+        g_session.untrackFd(fd);
+    }
+    errno = error;
+    return result;
+}
+
+double SysfsIo::monotonic() {
+    if (replaying()) {
+        g_session.next(Op::CLOCK, "");
+        return g_session.virtualNow();
+    }
+    uint64_t now = nowMicros();
+    if (recording()) {
+        g_session.record(Op::CLOCK, "", 0, 0, nullptr, now);
+    }
+    return now / 1e6;
+}
+
+void SysfsIo::sleep(double seconds) {
+    int64_t requested_us = static_cast<int64_t>(seconds * 1e6);
+    if (replaying()) {
+        // The virtual clock jumps to when the recorded sleep returned
+        g_session.next(Op::SLEEP, "");
+        return;
+    }
+
+    struct timespec ts;
+    ts.tv_sec = static_cast<time_t>(requested_us / 1000000);
+    ts.tv_nsec = static_cast<long>(requested_us % 1000000) * 1000;
+    nanosleep(&ts, nullptr);
+    if (recording()) {
+        g_session.record(Op::SLEEP, "", requested_us, 0);
+        g_session.flush();
+    }
+}
+
+std::vector<std::string> SysfsIo::environment(const std::function<bool(const std::string&)>& keep) {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::ENVIRONMENT, "");
+        return r != nullptr ? splitNames(r->data) : std::vector<std::string>();
+    }
+
+    // Filter before recording so unrelated variables (tokens, credentials) never reach the log
+    std::vector<std::string> entries;
+    for (char** env = environ; env != nullptr && *env != nullptr; ++env) {
+        std::string entry = *env;
+        if (keep(entry.substr(0, entry.find('=')))) {
+            entries.push_back(std::move(entry));
+        }
+    }
+    if (recording()) {
+        std::string joined = joinNames(entries);
+        g_session.record(Op::ENVIRONMENT, "", static_cast<int64_t>(entries.size()), 0, &joined);
+    }
+    return entries;
+}
+
+uint32_t SysfsIo::randomSeed() {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::RANDOM_SEED, "");
+        return r != nullptr ? static_cast<uint32_t>(r->result) : 0;
+    }
+    uint32_t seed = std::random_device{}();
+    if (recording()) {
+        g_session.record(Op::RANDOM_SEED, "", seed, 0);
+    }
+    return seed;
+}
+
+long SysfsIo::onlineCpus() {
+    if (replaying()) {
+        const Record* r = g_session.next(Op::ONLINE_CPUS, "");
+        return r != nullptr ? static_cast<long>(r->result) : 1;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (recording()) {
+        g_session.record(Op::ONLINE_CPUS, "", cpus, 0);
+    }
+    return cpus;
+}
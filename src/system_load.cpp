@@ -0,0 +1,122 @@
+/**
+ * @file system_load.cpp
+ * @brief Implementation of /proc based load sampling
+ */
+
+#include "system_load.hpp"
+#include "sysfs_io.hpp"
+#include <algorithm>
+#include <sstream>
+
+SystemLoad::SystemLoad()
+    : primed_(false)
+    , last_time_(0.0)
+    , last_cpu_total_(0)
+    , last_cpu_idle_(0)
+    , last_io_sectors_(0)
+    , cpu_load_(0.0)
+    , io_rate_mb_s_(0.0)
+    , disks_(findWholeDisks())
+{
+}
+
+std::vector<std::string> SystemLoad::findWholeDisks() {
+    // Partitions are listed in /proc/diskstats too; count only whole devices once
+    std::vector<std::string> disks;
+    std::vector<std::string> names;
+    if (!SysfsIo::listDirectory("/sys/block", names)) {
+        return disks;
+    }
+    for (const std::string& name : names) {
+        if (name.rfind("loop", 0) == 0 || name.rfind("ram", 0) == 0 ||
+            name.rfind("zram", 0) == 0) {
+            continue;
+        }
+        disks.push_back(name);
+    }
+    return disks;
+}
+
+bool SystemLoad::readCpuTimes(uint64_t& total, uint64_t& idle) const {
+    // The aggregate line comes first; the rest of the file is not needed
+    std::string contents;
+    if (!SysfsIo::readFile("/proc/stat", contents, 256)) {
+        return false;
+    }
+    std::istringstream stat_file(contents);
+    std::string label;
+    if (!(stat_file >> label) || label != "cpu") {
+        return false;
+    }
+
+    // user nice system idle iowait irq softirq steal
+    uint64_t fields[8] = {};
+    for (uint64_t& field : fields) {
+        if (!(stat_file >> field)) {
+            break;
+        }
+    }
+
+    total = 0;
+    for (uint64_t field : fields) {
+        total += field;
+    }
+    idle = fields[3] + fields[4];
+    return true;
+}
+
+bool SystemLoad::readIoSectors(uint64_t& sectors) const {
+    std::string contents;
+    if (!SysfsIo::readFile("/proc/diskstats", contents)) {
+        return false;
+    }
+    std::istringstream diskstats(contents);
+
+    sectors = 0;
+    std::string line;
+    while (std::getline(diskstats, line)) {
+        std::istringstream iss(line);
+        unsigned major = 0, minor = 0;
+        std::string name;
+        uint64_t reads, reads_merged, sectors_read, ms_reading;
+        uint64_t writes, writes_merged, sectors_written;
+        if (!(iss >> major >> minor >> name >> reads >> reads_merged >> sectors_read >>
+              ms_reading >> writes >> writes_merged >> sectors_written)) {
+            continue;
+        }
+        if (std::find(disks_.begin(), disks_.end(), name) == disks_.end()) {
+            continue;
+        }
+        sectors += sectors_read + sectors_written;
+    }
+    return true;
+}
+
+void SystemLoad::update(double time_seconds) {
+    uint64_t cpu_total = 0, cpu_idle = 0, io_sectors = 0;
+    bool cpu_ok = readCpuTimes(cpu_total, cpu_idle);
+    bool io_ok = readIoSectors(io_sectors);
+
+    if (primed_) {
+        double elapsed = time_seconds - last_time_;
+        if (cpu_ok && cpu_total > last_cpu_total_) {
+            double busy = static_cast<double>((cpu_total - last_cpu_total_) -
+                                              (cpu_idle - last_cpu_idle_));
+            cpu_load_ = std::clamp(busy / (cpu_total - last_cpu_total_), 0.0, 1.0);
+        }
+        if (io_ok && elapsed > 0.0 && io_sectors >= last_io_sectors_) {
+            // diskstats sectors are always 512 bytes
+            io_rate_mb_s_ = (io_sectors - last_io_sectors_) * 512.0 / 1e6 / elapsed;
+        }
+    }
+
+    primed_ = true;
+    last_time_ = time_seconds;
+    if (cpu_ok) {
+        last_cpu_total_ = cpu_total;
+        last_cpu_idle_ = cpu_idle;
+    }
+    if (io_ok) {
+        last_io_sectors_ = io_sectors;
+    }
+}
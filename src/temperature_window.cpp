@@ -0,0 +1,96 @@
+/**
+ * @file temperature_window.cpp
+ * @brief Implementation of rolling temperature statistics
+ */
+
+#include "temperature_window.hpp"
+#include <algorithm>
+#include <cmath>
+
+TemperatureWindow::TemperatureWindow(size_t capacity)
+    : samples_()
+    , capacity_(std::clamp<size_t>(capacity, 1, MAX_SAMPLES))
+    , head_(0)
+    , count_(0)
+{
+}
+
+void TemperatureWindow::push(double time_seconds, double temperature) {
+    samples_[head_] = {time_seconds, temperature};
+    head_ = (head_ + 1) % capacity_;
+    if (count_ < capacity_) {
+        count_++;
+    }
+}
+
+void TemperatureWindow::clear() {
+    head_ = 0;
+    count_ = 0;
+}
+
+const TemperatureWindow::Sample& TemperatureWindow::at(size_t index) const {
+    // index 0 is the oldest sample still in the window
+    return samples_[(head_ + capacity_ - count_ + index) % capacity_];
+}
+
+double TemperatureWindow::mean() const {
+    if (count_ == 0) {
+        return std::nan("");
+    }
+    double sum = 0.0;
+    for (size_t i = 0; i < count_; i++) {
+        sum += at(i).value;
+    }
+    return sum / count_;
+}
+
+double TemperatureWindow::peak() const {
+    if (count_ == 0) {
+        return std::nan("");
+    }
+    double result = at(0).value;
+    for (size_t i = 1; i < count_; i++) {
+        result = std::max(result, at(i).value);
+    }
+    return result;
+}
+
+double TemperatureWindow::minimum() const {
+    if (count_ == 0) {
+        return std::nan("");
+    }
+    double result = at(0).value;
+    for (size_t i = 1; i < count_; i++) {
+        result = std::min(result, at(i).value);
+    }
+    return result;
+}
+
+double TemperatureWindow::slope() const {
+    // Least-squares fit in °C per second; zero until two distinct timestamps exist
+    if (count_ < 2) {
+        return 0.0;
+    }
+
+    double t0 = at(0).time;
+    double sum_t = 0.0;
+    double sum_v = 0.0;
+    for (size_t i = 0; i < count_; i++) {
+        sum_t += at(i).time - t0;
+        sum_v += at(i).value;
+    }
+    double mean_t = sum_t / count_;
+    double mean_v = sum_v / count_;
+
+    double cov = 0.0;
+    double var = 0.0;
+    for (size_t i = 0; i < count_; i++) {
+        double dt = (at(i).time - t0) - mean_t;
+        cov += dt * (at(i).value - mean_v);
+        var += dt * dt;
+    }
+    if (var <= 0.0) {
+        return 0.0;
+    }
+    return cov / var;
+}
@@ -0,0 +1,186 @@
+/**
+ * @file thermal_simulator.cpp
+ * @brief Implementation of the fan policy simulator
+ */
+
+#include "thermal_simulator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <utility>
+
+ThermalSimulator::ThermalSimulator(const FanControllerConfig& config, const Plant& plant)
+    : config_(config)
+    , plant_(plant)
+    , initial_temperature_(plant.ambient)
+    , initial_level_(0)
+{
+}
+
+double ThermalSimulator::steadyState(double power, int level) const {
+    return plant_.ambient + power / plant_.conductance[level];
+}
+
+void ThermalSimulator::useSyntheticWorkload(double hours) {
+    // Idle most of the time with light, medium, heavy and burst phases of random length
+    static const double powers[] = {3.0, 4.5, 6.0, 8.0, 13.0};
+    std::discrete_distribution<int> phase({50, 20, 15, 10, 5});
+    std::uniform_real_distribution<double> length(30.0, 600.0);
+    std::mt19937 rng(42);
+
+    segments_.clear();
+    double end = 0.0;
+    double duration = std::max(hours, 0.01) * 3600.0;
+    while (end < duration) {
+        end = std::min(end + length(rng), duration);
+        segments_.push_back({end, powers[phase(rng)], -1});
+    }
+    initial_level_ = 0;
+    initial_temperature_ = steadyState(segments_.front().power, 0);
+}
+
+void ThermalSimulator::useTrace(const std::vector<ThermalTrace::Sample>& samples) {
+    segments_.clear();
+    initial_temperature_ = samples.front().temperature;
+    initial_level_ = std::clamp(samples.front().level, 0, 4);
+
+    // Over each interval solve T1 = Tss + (T0 - Tss) e^(-G dt / C) for the steady state Tss
+    double start = samples.front().time_s;
+    for (size_t k = 0; k + 1 < samples.size(); k++) {
+        double dt = samples[k + 1].time_s - samples[k].time_s;
+        if (dt <= 0.0) {
+            continue;
+        }
+        int level = std::clamp(samples[k].level, 0, 4);
+        double g = plant_.conductance[level];
+        double decay = std::exp(-g * dt / plant_.capacity);
+        double steady = (samples[k + 1].temperature - samples[k].temperature * decay) / (1.0 - decay);
+        double power = std::max(g * (steady - plant_.ambient), 0.0);
+        segments_.push_back({samples[k + 1].time_s - start, power, level});
+    }
+    if (segments_.empty()) {
+        // A single sample holds its temperature at the recorded level
+        double power = plant_.conductance[initial_level_] * (initial_temperature_ - plant_.ambient);
+        segments_.push_back({1.0, std::max(power, 0.0), initial_level_});
+    }
+}
+
+void ThermalSimulator::account(Scorecard& card, double temperature, int level, double dt) const {
+    card.duration += dt;
+    if (level > 0) {
+        card.fan_on_seconds += dt;
+    }
+    card.level_seconds += level * dt;
+    card.peak_temperature = std::max(card.peak_temperature, temperature);
+    double over = temperature - config_.full_threshold;
+    if (over > 0.0) {
+        card.overshoot_peak = std::max(card.overshoot_peak, over);
+        card.overshoot_integral += over * dt;
+    }
+}
+
+ThermalSimulator::Scorecard ThermalSimulator::run(FanPolicy& policy) const {
+    Scorecard card;
+    card.policy = policy.name();
+    card.peak_temperature = initial_temperature_;
+
+    std::vector<std::pair<double, int>> inputs;
+    double temperature = initial_temperature_;
+    int level = initial_level_;
+    double now = 0.0;
+    double next_decision = 0.0;
+    size_t segment = 0;
+    double end = segments_.back().end;
+
+    policy.reset();
+    while (now < end) {
+        if (now >= next_decision) {
+            inputs.emplace_back(temperature, level);
+            int next = std::clamp(policy.decide(temperature, level), 0, 4);
+            if (next != level) {
+                card.transitions++;
+                level = next;
+            }
+            next_decision = now + policy.pollInterval(temperature);
+        }
+        while (segments_[segment].end <= now) {
+            segment++;
+        }
+
+        // Exact step for a constant heat input and fan level
+        double dt = std::min({STEP_SECONDS, segments_[segment].end - now, next_decision - now});
+        double steady = steadyState(segments_[segment].power, level);
+        temperature = steady + (temperature - steady) *
+                      std::exp(-plant_.conductance[level] * dt / plant_.capacity);
+        account(card, temperature, level, dt);
+        now += dt;
+    }
+    card.decisions = inputs.size();
+
+    // Time the decisions separately so the plant integration does not count
+    if (!inputs.empty()) {
+        size_t repeats = std::max<size_t>(1, 200000 / inputs.size());
+        policy.reset();
+        auto start = std::chrono::steady_clock::now();
+        for (size_t r = 0; r < repeats; r++) {
+            for (const auto& input : inputs) {
+                policy.decide(input.first, input.second);
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        card.ns_per_decision = std::chrono::duration<double, std::nano>(elapsed).count() /
+                               static_cast<double>(repeats * inputs.size());
+    }
+    return card;
+}
+
+ThermalSimulator::Scorecard ThermalSimulator::runRecorded() const {
+    Scorecard card;
+    card.policy = "recorded";
+    card.peak_temperature = initial_temperature_;
+
+    double temperature = initial_temperature_;
+    int level = initial_level_;
+    double now = 0.0;
+    for (const Segment& segment : segments_) {
+        int next = segment.level < 0 ? level : segment.level;
+        if (next != level) {
+            card.transitions++;
+            level = next;
+        }
+        while (now < segment.end) {
+            double dt = std::min(STEP_SECONDS, segment.end - now);
+            double steady = steadyState(segment.power, level);
+            temperature = steady + (temperature - steady) *
+                          std::exp(-plant_.conductance[level] * dt / plant_.capacity);
+            account(card, temperature, level, dt);
+            now += dt;
+        }
+    }
+    return card;
+}
+
+void ThermalSimulator::printScorecards(std::ostream& out, const std::vector<Scorecard>& cards) {
+    out << std::left << std::setw(16) << "policy" << std::right
+        << std::setw(9) << "fan on%" << std::setw(11) << "mean lvl" << std::setw(10) << "trans/h"
+        << std::setw(9) << "peak C" << std::setw(11) << "over C" << std::setw(11) << "over C*s"
+        << std::setw(12) << "decisions/h" << std::setw(12) << "ns/decision" << "\n";
+
+    for (const Scorecard& card : cards) {
+        double hours = card.duration / 3600.0;
+        out << std::fixed << std::left << std::setw(16) << card.policy << std::right
+            << std::setprecision(1)
+            << std::setw(9) << (card.duration > 0.0 ? 100.0 * card.fan_on_seconds / card.duration : 0.0)
+            << std::setprecision(2)
+            << std::setw(11) << (card.duration > 0.0 ? card.level_seconds / card.duration : 0.0)
+            << std::setprecision(1)
+            << std::setw(10) << (hours > 0.0 ? card.transitions / hours : 0.0)
+            << std::setw(9) << card.peak_temperature
+            << std::setw(11) << card.overshoot_peak
+            << std::setw(11) << card.overshoot_integral
+            << std::setw(12) << (hours > 0.0 ? card.decisions / hours : 0.0)
+            << std::setw(12) << card.ns_per_decision << "\n";
+    }
+}
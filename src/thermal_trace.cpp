@@ -0,0 +1,92 @@
+/**
+ * @file thermal_trace.cpp
+ * @brief Implementation of the thermal trace format
+ */
+
+#include "thermal_trace.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <fstream>
+
+void ThermalTrace::appendRecord(std::string& out, std::string_view node, int64_t time_us,
+                                double temperature, int level) {
+    char buf[96];
+    char* p = buf;
+    char* end = buf + sizeof(buf);
+
+    int64_t seconds = time_us / 1000000;
+    int64_t micros = std::llabs(time_us % 1000000);
+
+    *p++ = ',';
+    p = std::to_chars(p, end, seconds).ptr;
+    *p++ = '.';
+    for (int64_t div = 100000; div > 0; div /= 10) {
+        *p++ = static_cast<char>('0' + (micros / div) % 10);
+    }
+    *p++ = ',';
+    p = std::to_chars(p, end, temperature, std::chars_format::fixed, 3).ptr;
+    *p++ = ',';
+    p = std::to_chars(p, end, level).ptr;
+    *p++ = '\n';
+
+    out.append(node);
+    out.append(buf, static_cast<size_t>(p - buf));
+}
+
+bool ThermalTrace::load(const std::string& path, std::string& node, std::vector<Sample>& samples,
+                        std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    samples.clear();
+    std::string line;
+    size_t line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        if (line.empty() || line + "\n" == HEADER) {
+            continue;
+        }
+
+        // Split from the right: node names may contain commas
+        size_t level_sep = line.rfind(',');
+        size_t temp_sep = level_sep == std::string::npos ? level_sep : line.rfind(',', level_sep - 1);
+        size_t time_sep = temp_sep == std::string::npos || temp_sep == 0 ? std::string::npos
+                                                                          : line.rfind(',', temp_sep - 1);
+        if (time_sep == std::string::npos) {
+            error = path + ":" + std::to_string(line_number) + ": expected node,time_s,temp_c,level";
+            return false;
+        }
+
+        std::string_view record_node(line.data(), time_sep);
+        if (node.empty()) {
+            node = std::string(record_node);
+        } else if (record_node != node) {
+            continue;
+        }
+
+        Sample sample{};
+        const char* end = line.data() + line.size();
+        bool ok = std::from_chars(line.data() + time_sep + 1, line.data() + temp_sep, sample.time_s).ec ==
+                      std::errc() &&
+                  std::from_chars(line.data() + temp_sep + 1, line.data() + level_sep, sample.temperature).ec ==
+                      std::errc() &&
+                  std::from_chars(line.data() + level_sep + 1, end, sample.level).ec == std::errc();
+        if (!ok) {
+            error = path + ":" + std::to_string(line_number) + ": malformed record";
+            return false;
+        }
+        samples.push_back(sample);
+    }
+
+    if (samples.empty()) {
+        error = node.empty() ? path + ": no samples" : path + ": no samples for node " + node;
+        return false;
+    }
+    std::stable_sort(samples.begin(), samples.end(),
+                     [](const Sample& a, const Sample& b) { return a.time_s < b.time_s; });
+    return true;
+}
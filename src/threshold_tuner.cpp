@@ -0,0 +1,276 @@
+/**
+ * @file threshold_tuner.cpp
+ * @brief Implementation of the online threshold tuner
+ */
+
+#include "threshold_tuner.hpp"
+#include "sysfs_io.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+const char STATE_MAGIC[4] = {'P', '5', 'T', 'B'};
+const uint8_t STATE_VERSION = 1;
+
+// Upper bounds of the idle temperature and load bands; the last band is open-ended
+const double AMBIENT_BAND_LIMITS[] = {45.0, 55.0};
+const double LOAD_BAND_LIMITS[] = {0.25, 0.75};
+
+std::string formatOffset(double value) {
+    std::ostringstream oss;
+    oss << std::showpos << std::fixed << std::setprecision(1) << value;
+    return oss.str();
+}
+
+} // namespace
+
+bool ThresholdTuner::initialize(const Settings& settings, std::string& error) {
+    settings_ = settings;
+    if (settings_.epoch_cycles < 1) {
+        error = "epoch must span at least one cycle";
+        return false;
+    }
+
+    // Only arms that keep FULL below the throttle point by the safety margin are explored
+    arms_.clear();
+    double limit = settings_.throttle_temp - settings_.safety_margin;
+    for (double threshold_offset : settings_.threshold_offsets) {
+        if (settings_.base_full_threshold + threshold_offset > limit) {
+            continue;
+        }
+        for (double hysteresis_offset : settings_.hysteresis_offsets) {
+            if (settings_.base_hysteresis + hysteresis_offset < 0.0) {
+                continue;
+            }
+            arms_.push_back({threshold_offset, hysteresis_offset});
+        }
+    }
+    if (arms_.empty()) {
+        std::ostringstream oss;
+        oss << "no arm keeps FULL_THRESHOLD at least " << settings_.safety_margin
+            << "°C below the throttle temperature";
+        error = oss.str();
+        return false;
+    }
+
+    cells_.assign(static_cast<size_t>(CONTEXTS) * arms_.size(), Cell());
+    context_ = 0;
+    current_arm_ = selectArm(context_);
+    epoch_ = Epoch();
+    return true;
+}
+
+bool ThresholdTuner::loadState(const std::string& path) {
+    std::string contents;
+    if (!SysfsIo::readFile(path, contents)) {
+        return false;
+    }
+
+    size_t offset = 0;
+    auto take = [&](void* out, size_t size) {
+        if (contents.size() - offset < size) {
+            return false;
+        }
+        std::memcpy(out, contents.data() + offset, size);
+        offset += size;
+        return true;
+    };
+
+    char magic[4];
+    uint8_t version = 0, contexts = 0;
+    uint16_t arm_count = 0;
+    bool ok = take(magic, 4) && std::memcmp(magic, STATE_MAGIC, 4) == 0 &&
+              take(&version, 1) && version == STATE_VERSION &&
+              take(&contexts, 1) && contexts == CONTEXTS &&
+              take(&arm_count, sizeof(arm_count)) &&
+              arm_count == arms_.size();
+
+    // The posterior only applies to the same arm set
+    for (size_t i = 0; ok && i < arms_.size(); i++) {
+        float offsets[2];
+        ok = take(offsets, sizeof(offsets)) &&
+             std::fabs(offsets[0] - arms_[i].threshold_offset) < 1e-3 &&
+             std::fabs(offsets[1] - arms_[i].hysteresis_offset) < 1e-3;
+    }
+
+    std::vector<Cell> cells(cells_.size());
+    ok = ok && take(cells.data(), sizeof(Cell) * cells.size());
+
+    if (!ok) {
+        std::cerr << "Tuner state " << path << " does not match the configured arms, starting fresh"
+                  << std::endl;
+        return false;
+    }
+    cells_ = cells;
+    current_arm_ = selectArm(context_);
+    return true;
+}
+
+bool ThresholdTuner::saveState(const std::string& path) const {
+    uint8_t contexts = CONTEXTS;
+    uint16_t arm_count = static_cast<uint16_t>(arms_.size());
+    std::string contents(STATE_MAGIC, 4);
+    contents.append(reinterpret_cast<const char*>(&STATE_VERSION), 1);
+    contents.append(reinterpret_cast<const char*>(&contexts), 1);
+    contents.append(reinterpret_cast<const char*>(&arm_count), sizeof(arm_count));
+    for (const Arm& arm : arms_) {
+        float offsets[2] = {static_cast<float>(arm.threshold_offset),
+                            static_cast<float>(arm.hysteresis_offset)};
+        contents.append(reinterpret_cast<const char*>(offsets), sizeof(offsets));
+    }
+    contents.append(reinterpret_cast<const char*>(cells_.data()), sizeof(Cell) * cells_.size());
+
+    // Written to a temporary file and renamed so a crash never leaves a torn state
+    if (!SysfsIo::replaceFile(path, contents)) {
+        std::cerr << "Failed to write tuner state: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int ThresholdTuner::contextFor(double idle_temp, double load) {
+    int ambient = 0;
+    while (ambient < AMBIENT_BANDS - 1 && idle_temp >= AMBIENT_BAND_LIMITS[ambient]) {
+        ambient++;
+    }
+    int load_band = 0;
+    while (load_band < LOAD_BANDS - 1 && load >= LOAD_BAND_LIMITS[load_band]) {
+        load_band++;
+    }
+    return ambient * LOAD_BANDS + load_band;
+}
+
+std::string ThresholdTuner::contextName(int context) {
+    static const char* const ambient_names[] = {"idle<45°C", "idle 45-55°C", "idle>=55°C"};
+    static const char* const load_names[] = {"load<25%", "load 25-75%", "load>=75%"};
+    return std::string(ambient_names[context / LOAD_BANDS]) + " " + load_names[context % LOAD_BANDS];
+}
+
+std::string ThresholdTuner::armName(size_t arm) const {
+    return "thresholds " + formatOffset(arms_[arm].threshold_offset) + "°C hysteresis " +
+           formatOffset(arms_[arm].hysteresis_offset) + "°C";
+}
+
+double ThresholdTuner::rewardFor(const Epoch& epoch) const {
+    double hours = epoch.cycles * settings_.interval_seconds / 3600.0;
+    double fan_effort = epoch.cycles > 0 ? epoch.level_sum / (4.0 * epoch.cycles) : 0.0;
+    double transitions_per_hour = hours > 0.0 ? epoch.transitions / hours : 0.0;
+    int throttle_events = epoch.throttle_events + (epoch.aborted ? 1 : 0);
+    return -(settings_.fan_weight * fan_effort +
+             settings_.transition_weight * transitions_per_hour +
+             settings_.throttle_weight * throttle_events);
+}
+
+size_t ThresholdTuner::selectArm(int context) {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    size_t best = 0;
+    double best_sample = -1e300;
+
+    for (size_t arm = 0; arm < arms_.size(); arm++) {
+        const Cell& cell = cells_[context * arms_.size() + arm];
+        double sample;
+        if (cell.count < 1.0f) {
+            // Unseen arms draw from a wide prior centred above typical rewards
+            sample = normal(rng_);
+        } else {
+            double sd = cell.count >= 2.0f ? std::sqrt(cell.m2 / (cell.count - 1.0f)) : 1.0;
+            sd = std::max(sd, 0.05);
+            sample = cell.mean + normal(rng_) * sd / std::sqrt(cell.count);
+        }
+        if (sample > best_sample) {
+            best_sample = sample;
+            best = arm;
+        }
+    }
+    return best;
+}
+
+bool ThresholdTuner::observe(double temperature, int level, double cpu_load) {
+    epoch_.cycles++;
+    epoch_.level_sum += level;
+    epoch_.min_temp = std::min(epoch_.min_temp, temperature);
+    epoch_.load_sum += cpu_load;
+    if (epoch_.last_level >= 0 && level != epoch_.last_level) {
+        epoch_.transitions++;
+    }
+    epoch_.last_level = level;
+
+    bool throttling = temperature >= settings_.throttle_temp;
+    if (throttling && !epoch_.throttling) {
+        epoch_.throttle_events++;
+    }
+    epoch_.throttling = throttling;
+
+    // Leave an exploratory arm that relaxes cooling as soon as the margin is breached;
+    // higher thresholds start the fan later and a narrower hysteresis stops it earlier
+    const Arm& arm = arms_[current_arm_];
+    bool relaxed = arm.threshold_offset > 0.0 || arm.hysteresis_offset < 0.0;
+    if (relaxed && temperature >= settings_.throttle_temp - settings_.safety_margin) {
+        epoch_.aborted = true;
+    }
+
+    if (epoch_.cycles < settings_.epoch_cycles && !epoch_.aborted) {
+        return false;
+    }
+
+    double reward = rewardFor(epoch_);
+    Cell& cell = cells_[context_ * arms_.size() + current_arm_];
+    cell.count += 1.0f;
+    float delta = static_cast<float>(reward) - cell.mean;
+    cell.mean += delta / cell.count;
+    cell.m2 += delta * (static_cast<float>(reward) - cell.mean);
+
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3) << contextName(context_) << ": "
+        << armName(current_arm_) << " reward " << reward << " (n=" << static_cast<int>(cell.count) << ")"
+        << (epoch_.aborted ? ", aborted at safety margin" : "");
+
+    context_ = contextFor(epoch_.min_temp, epoch_.load_sum / epoch_.cycles);
+    if (epoch_.aborted) {
+        // Retreat to the coolest arm until the next epoch: lowest thresholds, widest hysteresis
+        current_arm_ = 0;
+        for (size_t i = 1; i < arms_.size(); i++) {
+            const Arm& a = arms_[i];
+            const Arm& b = arms_[current_arm_];
+            if (a.threshold_offset < b.threshold_offset ||
+                (a.threshold_offset == b.threshold_offset && a.hysteresis_offset > b.hysteresis_offset)) {
+                current_arm_ = i;
+            }
+        }
+    } else {
+        current_arm_ = selectArm(context_);
+    }
+    oss << "; next " << contextName(context_) << ": " << armName(current_arm_);
+    last_summary_ = oss.str();
+
+    epoch_ = Epoch();
+    return true;
+}
+
+std::string ThresholdTuner::bestArmsSummary() const {
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3);
+    bool first = true;
+    for (int context = 0; context < CONTEXTS; context++) {
+        size_t best = arms_.size();
+        for (size_t arm = 0; arm < arms_.size(); arm++) {
+            const Cell& cell = cells_[context * arms_.size() + arm];
+            if (cell.count >= 1.0f &&
+                (best == arms_.size() || cell.mean > cells_[context * arms_.size() + best].mean)) {
+                best = arm;
+            }
+        }
+        if (best == arms_.size()) {
+            continue;
+        }
+        oss << (first ? "" : "; ") << contextName(context) << ": " << armName(best)
+            << " (" << cells_[context * arms_.size() + best].mean << ")";
+        first = false;
+    }
+    return first ? std::string("no completed epochs") : oss.str();
+}
@@ -0,0 +1,146 @@
+/**
+ * @file virtual_sensor.cpp
+ * @brief Implementation of state-space virtual temperature sensors
+ */
+
+#include "virtual_sensor.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <utility>
+
+bool VirtualSensor::configure(const VirtualSensorConfig& config, std::string& error) {
+    // The name must be usable as a variable in POLICY_EXPR
+    auto identifier_char = [](char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; };
+    if (config.name.empty() || std::isdigit(static_cast<unsigned char>(config.name[0])) ||
+        !std::all_of(config.name.begin(), config.name.end(), identifier_char)) {
+        error = "invalid virtual sensor name '" + config.name + "'";
+        return false;
+    }
+
+    // A is n x n; every other matrix is sized from n
+    size_t n = 0;
+    while (n * n < config.a.size()) {
+        n++;
+    }
+    if (n == 0 || n * n != config.a.size() || n > MAX_STATES) {
+        error = config.name + ": A must be a square matrix of at most " +
+                std::to_string(MAX_STATES) + "x" + std::to_string(MAX_STATES) + " values";
+        return false;
+    }
+    if (config.b.size() != n * INPUT_COUNT) {
+        error = config.name + ": B needs " + std::to_string(n * INPUT_COUNT) +
+                " values (" + std::to_string(n) + " states x " +
+                std::to_string(INPUT_COUNT) + " inputs)";
+        return false;
+    }
+    if (config.c.size() != n) {
+        error = config.name + ": C needs " + std::to_string(n) + " values";
+        return false;
+    }
+    if (!config.d.empty() && config.d.size() != INPUT_COUNT) {
+        error = config.name + ": D needs " + std::to_string(INPUT_COUNT) + " values";
+        return false;
+    }
+
+    name_ = config.name;
+    fuse_ = config.fuse;
+    states_ = n;
+    initialized_ = false;
+    a_.fill(0.0);
+    b_.fill(0.0);
+    c_.fill(0.0);
+    d_.fill(0.0);
+    for (size_t i = 0; i < config.a.size(); i++) {
+        a_[i] = config.a[i];
+    }
+    for (size_t i = 0; i < config.b.size(); i++) {
+        b_[i] = config.b[i];
+    }
+    for (size_t i = 0; i < config.c.size(); i++) {
+        c_[i] = config.c[i];
+    }
+    for (size_t i = 0; i < config.d.size(); i++) {
+        d_[i] = config.d[i];
+    }
+    return true;
+}
+
+void VirtualSensor::initializeSteadyState(const Inputs& inputs) {
+    // Start from equilibrium for the first inputs: solve (I - A) x = B u
+    double m[MAX_STATES][MAX_STATES + 1];
+    for (size_t i = 0; i < states_; i++) {
+        for (size_t j = 0; j < states_; j++) {
+            m[i][j] = (i == j ? 1.0 : 0.0) - a_[i * states_ + j];
+        }
+        double rhs = 0.0;
+        for (size_t k = 0; k < INPUT_COUNT; k++) {
+            rhs += b_[i * INPUT_COUNT + k] * inputs[k];
+        }
+        m[i][states_] = rhs;
+    }
+
+    for (size_t col = 0; col < states_; col++) {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < states_; row++) {
+            if (std::fabs(m[row][col]) > std::fabs(m[pivot][col])) {
+                pivot = row;
+            }
+        }
+        if (std::fabs(m[pivot][col]) < 1e-12) {
+            // Marginally stable model (pure integrator); assume ambient is the SoC
+            for (size_t i = 0; i < states_; i++) {
+                x_[i] = inputs[INPUT_SOC_TEMP];
+            }
+            return;
+        }
+        if (pivot != col) {
+            for (size_t j = 0; j <= states_; j++) {
+                std::swap(m[col][j], m[pivot][j]);
+            }
+        }
+        for (size_t row = 0; row < states_; row++) {
+            if (row == col) {
+                continue;
+            }
+            double factor = m[row][col] / m[col][col];
+            for (size_t j = col; j <= states_; j++) {
+                m[row][j] -= factor * m[col][j];
+            }
+        }
+    }
+    for (size_t i = 0; i < states_; i++) {
+        x_[i] = m[i][states_] / m[i][i];
+    }
+}
+
+double VirtualSensor::update(const Inputs& inputs) {
+    if (!initialized_) {
+        initializeSteadyState(inputs);
+        initialized_ = true;
+    }
+
+    double y = 0.0;
+    for (size_t k = 0; k < INPUT_COUNT; k++) {
+        y += d_[k] * inputs[k];
+    }
+    for (size_t i = 0; i < states_; i++) {
+        y += c_[i] * x_[i];
+    }
+    value_ = y;
+
+    std::array<double, MAX_STATES> next{};
+    for (size_t i = 0; i < states_; i++) {
+        double acc = 0.0;
+        for (size_t j = 0; j < states_; j++) {
+            acc += a_[i * states_ + j] * x_[j];
+        }
+        for (size_t k = 0; k < INPUT_COUNT; k++) {
+            acc += b_[i * INPUT_COUNT + k] * inputs[k];
+        }
+        next[i] = acc;
+    }
+    x_ = next;
+
+    return value_;
+}